@@ -0,0 +1,283 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <rapidjson/rapidjson.h>
+
+namespace json_utils
+{
+namespace detail
+{
+/**
+ * A bounds-checked cursor over the bytes of a binary document, as consumed by the MessagePack and
+ * CBOR readers.
+ **/
+class binary_input
+{
+  public:
+    binary_input(const std::uint8_t* data, std::size_t size) noexcept
+        : m_begin{ data }, m_cursor{ data }, m_end{ data + size }
+    {
+    }
+
+    bool at_end() const noexcept
+    {
+        return m_cursor == m_end;
+    }
+
+    std::size_t offset() const noexcept
+    {
+        return static_cast<std::size_t>(m_cursor - m_begin);
+    }
+
+    std::uint8_t peek_byte()
+    {
+        require(1);
+        return *m_cursor;
+    }
+
+    std::uint8_t read_byte()
+    {
+        require(1);
+        return *m_cursor++;
+    }
+
+    std::uint64_t read_big_endian(std::size_t size)
+    {
+        require(size);
+
+        std::uint64_t value = 0;
+        for (std::size_t index = 0; index < size; ++index) {
+            value = (value << 8) | *m_cursor++;
+        }
+
+        return value;
+    }
+
+    /**
+     * @returns A pointer to the next `size` bytes, which are skipped over.
+     **/
+    const char* read_bytes(std::uint64_t size)
+    {
+        if (size > std::numeric_limits<rapidjson::SizeType>::max()) {
+            fail("String too long");
+        }
+
+        require(static_cast<std::size_t>(size));
+
+        const auto* const bytes = reinterpret_cast<const char*>(m_cursor);
+        m_cursor += size;
+
+        return bytes;
+    }
+
+    [[noreturn]] void fail(const std::string& message) const
+    {
+        throw std::runtime_error{ "Error: " + message + " at offset " +
+                                  std::to_string(offset()) + "." };
+    }
+
+  private:
+    void require(std::size_t size) const
+    {
+        if (static_cast<std::size_t>(m_end - m_cursor) < size) {
+            fail("Unexpected end of input");
+        }
+    }
+
+    const std::uint8_t* m_begin;
+    const std::uint8_t* m_cursor;
+    const std::uint8_t* m_end;
+};
+
+/**
+ * Keeps track of the open arrays and maps while a binary document is decoded, so that documents are
+ * decoded iteratively, and arbitrarily deep nesting can't overflow the call stack.
+ **/
+class binary_container_stack
+{
+  public:
+    /**
+     * Used as the element count of containers whose length isn't encoded up front (i.e., CBOR's
+     * indefinite-length arrays and maps), which are terminated by a break marker instead.
+     **/
+    static constexpr std::uint64_t indefinite = std::numeric_limits<std::uint64_t>::max();
+
+    static constexpr std::uint8_t break_marker = 0xFF;
+
+    struct frame
+    {
+        std::uint64_t remaining;
+        rapidjson::SizeType count;
+        bool is_object;
+        bool expects_key;
+
+        /**
+         * @returns True once all elements have been read, which, for an object, includes the value
+         * of the last member.
+         **/
+        bool is_complete() const noexcept
+        {
+            return remaining == 0 && (!is_object || expects_key);
+        }
+    };
+
+    bool empty() const noexcept
+    {
+        return m_frames.empty();
+    }
+
+    frame& top() noexcept
+    {
+        return m_frames.back();
+    }
+
+    void push(std::uint64_t element_count, bool is_object)
+    {
+        m_frames.push_back({ element_count, 0, is_object, is_object });
+    }
+
+    /**
+     * @returns The closed container.
+     **/
+    frame pop()
+    {
+        const auto closed = m_frames.back();
+        m_frames.pop_back();
+
+        complete_value();
+
+        return closed;
+    }
+
+    /**
+     * Records the start of an array element or of an object member, the key of which is read next.
+     **/
+    void begin_element() noexcept
+    {
+        auto& current = m_frames.back();
+
+        if (current.remaining != indefinite) {
+            --current.remaining;
+        }
+
+        ++current.count;
+    }
+
+    /**
+     * Records that a value (either a scalar, or a container that has just been closed) is complete,
+     * so that the enclosing object expects a key next.
+     **/
+    void complete_value() noexcept
+    {
+        if (!m_frames.empty() && m_frames.back().is_object) {
+            m_frames.back().expects_key = true;
+        }
+    }
+
+  private:
+    std::vector<frame> m_frames;
+};
+
+inline void check_handler_result(const binary_input& input, bool result)
+{
+    if (!result) {
+        input.fail("Terminated by handler");
+    }
+}
+
+/**
+ * @returns True if the container has been read in its entirety, in which case a break marker that
+ * terminates an indefinite-length container has been consumed.
+ **/
+inline bool at_container_end(binary_input& input, const binary_container_stack::frame& container)
+{
+    if (container.remaining != binary_container_stack::indefinite) {
+        return container.is_complete();
+    }
+
+    if (container.is_object && !container.expects_key) {
+        return false;
+    }
+
+    if (input.peek_byte() != binary_container_stack::break_marker) {
+        return false;
+    }
+
+    input.read_byte();
+    return true;
+}
+
+/**
+ * Decodes a binary document iteratively. The `DecoderType` supplies the format-specific parts, as
+ * `read_key(input, handler)`, which reads a map key, and `read_value(input, containers, handler)`,
+ * which reads a value, and either marks it as complete or opens a container.
+ **/
+template <typename DecoderType, typename HandlerType>
+void decode_binary_document(const std::uint8_t* data, std::size_t size, HandlerType& handler)
+{
+    binary_input input{ data, size };
+    binary_container_stack containers;
+
+    do {
+        if (containers.empty()) {
+            DecoderType::read_value(input, containers, handler);
+            continue;
+        }
+
+        auto& container = containers.top();
+
+        if (at_container_end(input, container)) {
+            const auto closed = containers.pop();
+            check_handler_result(
+                input, closed.is_object ? handler.EndObject(closed.count)
+                                        : handler.EndArray(closed.count));
+        } else if (!container.is_object) {
+            containers.begin_element();
+            DecoderType::read_value(input, containers, handler);
+        } else if (container.expects_key) {
+            containers.begin_element();
+            container.expects_key = false;
+            DecoderType::read_key(input, handler);
+        } else {
+            DecoderType::read_value(input, containers, handler);
+        }
+    } while (!containers.empty());
+
+    if (!input.at_end()) {
+        input.fail("The document root must not be followed by other values");
+    }
+}
+
+/**
+ * Reports an integer to the handler in the same way that `rapidjson::Reader` does, using the
+ * narrowest of `Int(...)`, `Uint(...)`, `Int64(...)`, and `Uint64(...)` that holds the value.
+ **/
+template <typename HandlerType> bool report_unsigned(HandlerType& handler, std::uint64_t value)
+{
+    if (value <= std::numeric_limits<unsigned>::max()) {
+        return handler.Uint(static_cast<unsigned>(value));
+    }
+
+    return handler.Uint64(value);
+}
+
+template <typename HandlerType> bool report_signed(HandlerType& handler, std::int64_t value)
+{
+    if (value >= 0) {
+        return report_unsigned(handler, static_cast<std::uint64_t>(value));
+    }
+
+    if (value >= std::numeric_limits<int>::min()) {
+        return handler.Int(static_cast<int>(value));
+    }
+
+    return handler.Int64(value);
+}
+} // namespace detail
+} // namespace json_utils
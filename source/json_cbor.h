@@ -0,0 +1,287 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+
+#include <rapidjson/rapidjson.h>
+
+#include "json_binary_reader.h"
+
+namespace json_utils
+{
+namespace cbor
+{
+/**
+ * The CBOR major types, as defined by RFC 8949.
+ **/
+enum major_type : std::uint8_t
+{
+    unsigned_integer = 0,
+    negative_integer = 1,
+    byte_string = 2,
+    text_string = 3,
+    array = 4,
+    map = 5,
+    tag = 6,
+    simple = 7
+};
+
+/**
+ * The additional information values of major type 7 that have a JSON equivalent, as well as those
+ * that describe how a data item's argument is encoded.
+ **/
+enum additional_info : std::uint8_t
+{
+    false_value = 20,
+    true_value = 21,
+    null_value = 22,
+    undefined_value = 23,
+    one_byte_argument = 24,
+    half_precision = 25,
+    single_precision = 26,
+    double_precision = 27,
+    indefinite_length = 31
+};
+} // namespace cbor
+
+namespace detail
+{
+struct cbor_decoder
+{
+    template <typename HandlerType>
+    static void read_key(binary_input& input, HandlerType& handler)
+    {
+        const auto initial = skip_tags(input);
+
+        if (major_type_of(initial) != cbor::text_string) {
+            input.fail("Map keys must be strings");
+        }
+
+        read_text(input, initial, [&](const char* data, rapidjson::SizeType length) {
+            return handler.Key(data, length, true);
+        });
+    }
+
+    template <typename HandlerType>
+    static void
+    read_value(binary_input& input, binary_container_stack& containers, HandlerType& handler)
+    {
+        const auto initial = skip_tags(input);
+        const auto info = static_cast<std::uint8_t>(initial & 0x1F);
+
+        switch (major_type_of(initial)) {
+            case cbor::unsigned_integer:
+                check_handler_result(input, report_unsigned(handler, read_argument(input, info)));
+                break;
+            case cbor::negative_integer:
+                read_negative_integer(input, handler, read_argument(input, info));
+                break;
+            case cbor::text_string:
+                read_text(input, initial, [&](const char* data, rapidjson::SizeType length) {
+                    return handler.String(data, length, true);
+                });
+                break;
+            case cbor::array:
+            case cbor::map: {
+                const auto is_object = major_type_of(initial) == cbor::map;
+                const auto element_count = read_length(input, info);
+
+                check_handler_result(
+                    input, is_object ? handler.StartObject() : handler.StartArray());
+                containers.push(element_count, is_object);
+
+                return;
+            }
+            case cbor::simple:
+                read_simple_value(input, handler, info);
+                break;
+            default:
+                input.fail("Unsupported CBOR type");
+        }
+
+        containers.complete_value();
+    }
+
+    static std::uint8_t major_type_of(std::uint8_t initial) noexcept
+    {
+        return static_cast<std::uint8_t>(initial >> 5);
+    }
+
+    /**
+     * Tags only attach semantics (e.g., a date format) to the data item that follows, which is
+     * reported as is.
+     **/
+    static std::uint8_t skip_tags(binary_input& input)
+    {
+        auto initial = input.read_byte();
+
+        while (major_type_of(initial) == cbor::tag) {
+            read_argument(input, static_cast<std::uint8_t>(initial & 0x1F));
+            initial = input.read_byte();
+        }
+
+        return initial;
+    }
+
+    static std::uint64_t read_argument(binary_input& input, std::uint8_t info)
+    {
+        if (info < cbor::one_byte_argument) {
+            return info;
+        }
+
+        if (info > cbor::double_precision) {
+            input.fail("Invalid CBOR argument");
+        }
+
+        return input.read_big_endian(std::size_t{ 1 } << (info - cbor::one_byte_argument));
+    }
+
+    /**
+     * @returns The length of a string or container, or `binary_container_stack::indefinite`.
+     **/
+    static std::uint64_t read_length(binary_input& input, std::uint8_t info)
+    {
+        if (info == cbor::indefinite_length) {
+            return binary_container_stack::indefinite;
+        }
+
+        return read_argument(input, info);
+    }
+
+    /**
+     * Reports a text string to the callback. Definite-length strings are reported in place, while
+     * the chunks of an indefinite-length string have to be joined first.
+     **/
+    template <typename CallbackType>
+    static void read_text(binary_input& input, std::uint8_t initial, CallbackType&& report)
+    {
+        const auto length = read_length(input, static_cast<std::uint8_t>(initial & 0x1F));
+
+        if (length != binary_container_stack::indefinite) {
+            const auto* const data = input.read_bytes(length);
+            check_handler_result(input, report(data, static_cast<rapidjson::SizeType>(length)));
+            return;
+        }
+
+        std::string text;
+
+        for (auto chunk = input.read_byte(); chunk != binary_container_stack::break_marker;
+             chunk = input.read_byte()) {
+            const auto info = static_cast<std::uint8_t>(chunk & 0x1F);
+
+            if (major_type_of(chunk) != cbor::text_string || info == cbor::indefinite_length) {
+                input.fail("Invalid chunk in indefinite-length string");
+            }
+
+            const auto chunk_length = read_argument(input, info);
+            text.append(input.read_bytes(chunk_length), static_cast<std::size_t>(chunk_length));
+        }
+
+        if (text.size() > std::numeric_limits<rapidjson::SizeType>::max()) {
+            input.fail("String too long");
+        }
+
+        check_handler_result(
+            input, report(text.data(), static_cast<rapidjson::SizeType>(text.size())));
+    }
+
+    /**
+     * A negative integer is encoded as `-1 - n`; values beyond the range of a 64-bit integer are
+     * reported as doubles, just like `rapidjson::Reader` reports out-of-range integers.
+     **/
+    template <typename HandlerType>
+    static void read_negative_integer(binary_input& input, HandlerType& handler, std::uint64_t n)
+    {
+        if (n <= static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max())) {
+            const auto value = -1 - static_cast<std::int64_t>(n);
+            check_handler_result(input, report_signed(handler, value));
+        } else {
+            check_handler_result(input, handler.Double(-1.0 - static_cast<double>(n)));
+        }
+    }
+
+    template <typename HandlerType>
+    static void read_simple_value(binary_input& input, HandlerType& handler, std::uint8_t info)
+    {
+        switch (info) {
+            case cbor::false_value:
+            case cbor::true_value:
+                check_handler_result(input, handler.Bool(info == cbor::true_value));
+                break;
+            case cbor::null_value:
+            case cbor::undefined_value:
+                check_handler_result(input, handler.Null());
+                break;
+            case cbor::half_precision:
+                check_handler_result(
+                    input, handler.Double(decode_half(input.read_big_endian(2))));
+                break;
+            case cbor::single_precision: {
+                const auto bits = static_cast<std::uint32_t>(input.read_big_endian(4));
+
+                float value;
+                std::memcpy(&value, &bits, sizeof value);
+
+                check_handler_result(input, handler.Double(value));
+                break;
+            }
+            case cbor::double_precision: {
+                const auto bits = input.read_big_endian(8);
+
+                double value;
+                std::memcpy(&value, &bits, sizeof value);
+
+                check_handler_result(input, handler.Double(value));
+                break;
+            }
+            case cbor::indefinite_length:
+                input.fail("Unexpected break");
+            default:
+                input.fail("Unsupported CBOR simple value");
+        }
+    }
+
+    static double decode_half(std::uint64_t bits) noexcept
+    {
+        const auto exponent = static_cast<int>((bits >> 10) & 0x1F);
+        const auto mantissa = static_cast<double>(bits & 0x3FF);
+
+        double value;
+        if (exponent == 0) {
+            value = std::ldexp(mantissa, -24);
+        } else if (exponent != 31) {
+            value = std::ldexp(mantissa + 1024, exponent - 25);
+        } else {
+            value = mantissa == 0 ? std::numeric_limits<double>::infinity()
+                                  : std::numeric_limits<double>::quiet_NaN();
+        }
+
+        return (bits & 0x8000) != 0 ? -value : value;
+    }
+};
+} // namespace detail
+
+/**
+ * Decodes a CBOR document, and reports its contents to a handler as the same sequence of events
+ * that `rapidjson::Reader` produces for the equivalent JSON text, just like the `msgpack_reader`.
+ *
+ * Both definite and indefinite-length strings, arrays, and maps are supported. Tags are skipped,
+ * and `undefined` is reported as null. Byte strings, and maps with non-string keys, have no JSON
+ * equivalent, and are rejected.
+ *
+ * Malformed input, and handlers that return false, cause a `std::runtime_error` to be thrown.
+ **/
+class cbor_reader
+{
+  public:
+    template <typename HandlerType>
+    void parse(const std::uint8_t* data, std::size_t size, HandlerType& handler) const
+    {
+        detail::decode_binary_document<detail::cbor_decoder>(data, size, handler);
+    }
+};
+} // namespace json_utils
@@ -0,0 +1,246 @@
+#pragma once
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "future_std.h"
+#include "json_ranges.h"
+#include "json_serializer.h"
+#include "json_traits.h"
+
+namespace json_utils
+{
+/**
+ * Describes a single column of a record type, by the name of the column and a projection that
+ * yields the column's value for a given record. The projection can either be a pointer to a data
+ * member, or a callable that accepts the record.
+ **/
+template <typename ProjectionType> struct column_descriptor
+{
+    const char* name;
+    ProjectionType projection;
+};
+
+template <typename ProjectionType>
+column_descriptor<ProjectionType> column(const char* name, ProjectionType projection)
+{
+    return { name, std::move(projection) };
+}
+
+/**
+ * Specialize this template to register a record type for columnar output, by providing a static
+ * `columns()` function that returns a tuple of `json_utils::column(...)` descriptors:
+ *
+ * @code
+ * namespace json_utils
+ * {
+ * template <> struct column_layout<sample::point>
+ * {
+ *     static auto columns()
+ *     {
+ *         return std::make_tuple(column("x", &sample::point::x), column("y", &sample::point::y));
+ *     }
+ * };
+ * }
+ * @endcode
+ **/
+template <typename RecordType> struct column_layout
+{
+};
+
+/**
+ * Serializes a range of records as a single JSON object that maps each field to an array holding
+ * that field's value for every record, in order. Construct it via `json_utils::as_columns(...)`.
+ **/
+template <typename RangeType> class columnar_range
+{
+  public:
+    explicit columnar_range(RangeType&& range) : m_range{ std::forward<RangeType>(range) }
+    {
+    }
+
+    auto& range() const noexcept
+    {
+        return m_range.get();
+    }
+
+  private:
+    detail::range_holder<RangeType> m_range;
+};
+
+/**
+ * Wraps a range of records so that it is serialized in columns (i.e., as a struct of arrays), such
+ * that every key is only written once. The records can either be maps that all share the same set
+ * of keys, or instances of a type that has a `column_layout<...>` specialization.
+ *
+ * @note The range is iterated over once per column, and, for maps, once more beforehand, to check
+ * that every record has as many keys as the first.
+ **/
+template <typename RangeType> columnar_range<RangeType> as_columns(RangeType&& range)
+{
+    return columnar_range<RangeType>{ std::forward<RangeType>(range) };
+}
+
+namespace serializer
+{
+namespace detail
+{
+template <typename, typename = void> struct has_column_layout : std::false_type
+{
+};
+
+template <typename RecordType>
+struct has_column_layout<
+    RecordType, future_std::void_t<decltype(column_layout<RecordType>::columns())>>
+    : std::true_type
+{
+};
+
+/**
+ * Whether records of this type can be looked up by key, as is required in order to write them in
+ * columns without a `column_layout<...>` specialization.
+ **/
+template <typename, typename = void> struct is_keyed_record : std::false_type
+{
+};
+
+template <typename RecordType>
+struct is_keyed_record<
+    RecordType,
+    future_std::void_t<
+        decltype(std::declval<const RecordType&>().size()),
+        decltype(std::declval<const RecordType&>().find(
+                     std::declval<const typename RecordType::key_type&>()) ==
+                 std::declval<const RecordType&>().end())>>
+    : std::integral_constant<bool, traits::treat_as_object_sink_v<RecordType>>
+{
+};
+
+template <typename RecordType, typename MemberType, typename ClassType>
+const MemberType& project(MemberType ClassType::*member, const RecordType& record) noexcept
+{
+    return record.*member;
+}
+
+template <typename RecordType, typename ProjectionType>
+auto project(const ProjectionType& projection, const RecordType& record)
+    -> decltype(projection(record))
+{
+    return projection(record);
+}
+
+template <typename WriterType, typename RangeType, typename ProjectionType>
+void write_column(
+    WriterType& writer, RangeType& range, const column_descriptor<ProjectionType>& column)
+{
+    const auto name_length = std::char_traits<char>::length(column.name);
+
+    write_aliased_key(writer, column.name, name_length);
+    writer.StartArray();
+
+    for_each_element(range, [&](const auto& record) {
+        to_json(writer, project(column.projection, record));
+    });
+
+    writer.EndArray();
+}
+
+template <typename WriterType, typename RangeType, typename ColumnsType, std::size_t... Indices>
+void write_columns(
+    WriterType& writer, RangeType& range, const ColumnsType& columns,
+    std::index_sequence<Indices...>)
+{
+    using expand = int[];
+    static_cast<void>(expand{ 0, (write_column(writer, range, std::get<Indices>(columns)), 0)... });
+}
+
+/**
+ * Writes the columns that are registered for the record type, so that even an empty range yields
+ * every column.
+ **/
+template <typename WriterType, typename RecordType, typename RangeType>
+void write_columnar_records(WriterType& writer, RangeType& range, std::true_type)
+{
+    static_assert(
+        std::is_same<typename WriterType::Ch, char>::value,
+        "Registered columns can only be written by a narrow character writer.");
+
+    const auto columns = column_layout<RecordType>::columns();
+    constexpr auto column_count = std::tuple_size<std::decay_t<decltype(columns)>>::value;
+
+    writer.StartObject();
+    write_columns(writer, range, columns, std::make_index_sequence<column_count>{});
+    writer.EndObject();
+}
+
+[[noreturn]] inline void throw_mismatched_columns()
+{
+    throw std::invalid_argument{ "Every record must have the same keys to be written in columns." };
+}
+
+/**
+ * Writes one column per key of the first record. Every other record must have exactly the same
+ * keys, which are looked up, so that maps that don't iterate in a consistent order (e.g.,
+ * `std::unordered_map<...>`) are supported as well.
+ **/
+template <typename WriterType, typename RecordType, typename RangeType>
+void write_columnar_records(WriterType& writer, RangeType& range, std::false_type)
+{
+    static_assert(
+        is_keyed_record<RecordType>::value,
+        "Records must either be maps that support size(), find(key) and end(), or have a "
+        "column_layout<...> specialization.");
+
+    using std::begin;
+    using std::end;
+
+    writer.StartObject();
+
+    const auto first = begin(range);
+    if (first != end(range)) {
+        const auto& head = *first;
+
+        // Checked up front, since a record with extra keys would otherwise go unnoticed when the
+        // first record has no keys at all, and so yields no columns in which to look them up.
+        for_each_element(range, [&](const auto& record) {
+            if (RAPIDJSON_UNLIKELY(record.size() != head.size())) {
+                throw_mismatched_columns();
+            }
+        });
+
+        for (const auto& member : head) {
+            insert_key(writer, member.first);
+            writer.StartArray();
+
+            for_each_element(range, [&](const auto& record) {
+                const auto match = record.find(member.first);
+                if (RAPIDJSON_UNLIKELY(match == record.end())) {
+                    throw_mismatched_columns();
+                }
+
+                to_json(writer, match->second);
+            });
+
+            writer.EndArray();
+        }
+    }
+
+    writer.EndObject();
+}
+
+template <typename WriterType, typename RangeType>
+void to_json(WriterType& writer, const columnar_range<RangeType>& data)
+{
+    using std::begin;
+    using record_type = std::decay_t<decltype(*begin(data.range()))>;
+
+    write_columnar_records<WriterType, record_type>(
+        writer, data.range(), has_column_layout<record_type>{});
+}
+} // namespace detail
+} // namespace serializer
+} // namespace json_utils
@@ -0,0 +1,816 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if __cplusplus >= 201703L // C++17
+#include <filesystem>
+#endif
+
+// clang-format off
+#ifdef JSON_UTILS_HAS_ZLIB
+    #include <zlib.h>
+#endif
+
+#ifdef JSON_UTILS_HAS_ZSTD
+    #include <zstd.h>
+#endif
+// clang-format on
+
+#include <rapidjson/rapidjson.h>
+
+#include "json_output_streams.h"
+
+namespace json_utils
+{
+enum class compression_codec
+{
+    /**
+     * When writing, the codec is chosen based on the file extension (`.gz` or `.zst`). When
+     * reading, it's chosen based on the magic bytes at the start of the file, and files that
+     * aren't compressed are read as is.
+     **/
+    automatic,
+    none,
+    gzip,
+    zstd
+};
+
+struct compression_options
+{
+    compression_codec codec = compression_codec::automatic;
+
+    /**
+     * The compression level; zero selects the codec's default level.
+     **/
+    int level = 0;
+
+    file_write_options file;
+};
+
+namespace detail
+{
+inline bool ends_with(const std::string& text, const char* suffix)
+{
+    const auto length = std::strlen(suffix);
+    return text.size() >= length && text.compare(text.size() - length, length, suffix) == 0;
+}
+
+/**
+ * @throws std::invalid_argument if the path doesn't have a recognized extension.
+ **/
+inline compression_codec codec_from_extension(const std::string& path)
+{
+    if (ends_with(path, ".gz")) {
+        return compression_codec::gzip;
+    }
+
+    if (ends_with(path, ".zst") || ends_with(path, ".zstd")) {
+        return compression_codec::zstd;
+    }
+
+    throw std::invalid_argument{ "Could not determine the compression codec of " + path + "." };
+}
+
+inline compression_codec codec_from_magic(const char* data, std::size_t size) noexcept
+{
+    const auto* const bytes = reinterpret_cast<const unsigned char*>(data);
+
+    if (size >= 2 && bytes[0] == 0x1F && bytes[1] == 0x8B) {
+        return compression_codec::gzip;
+    }
+
+    if (size >= 4 && bytes[0] == 0x28 && bytes[1] == 0xB5 && bytes[2] == 0x2F && bytes[3] == 0xFD) {
+        return compression_codec::zstd;
+    }
+
+    return compression_codec::none;
+}
+
+[[noreturn]] inline void throw_codec_unavailable(const char* name)
+{
+    throw std::runtime_error{ std::string{ "Support for " } + name +
+                              " compression is not enabled." };
+}
+
+constexpr std::size_t compression_buffer_size = 256 * 1024;
+
+class encoder
+{
+  public:
+    virtual ~encoder() = default;
+
+    /**
+     * Compresses the data, and writes any output that becomes available to the sink. Once `finish`
+     * is set, the compressed stream is terminated.
+     **/
+    virtual void
+    encode(const char* data, std::size_t size, bool finish, file_output_stream& sink) = 0;
+};
+
+class decoder
+{
+  public:
+    virtual ~decoder() = default;
+
+    /**
+     * Fills the output buffer with decompressed data.
+     *
+     * @returns The number of characters produced, which is less than the capacity only once the
+     * end of the data has been reached.
+     **/
+    virtual std::size_t decode(char* output, std::size_t capacity) = 0;
+};
+
+/**
+ * Reads a file in large chunks. The first chunk is read up front, so that the codec can be
+ * determined from its magic bytes.
+ **/
+class file_source
+{
+  public:
+    explicit file_source(const std::string& path)
+        : m_file{ path, std::ios::in | std::ios::binary }, m_buffer(64 * 1024)
+    {
+        if (!m_file.is_open()) {
+            throw std::runtime_error{ "Could not open " + path + " for reading." };
+        }
+
+        read_chunk();
+    }
+
+    const char* header() const noexcept
+    {
+        return m_buffer.data();
+    }
+
+    std::size_t header_size() const noexcept
+    {
+        return m_size;
+    }
+
+    /**
+     * @returns The size of the next chunk of the file, which is zero at the end of the file.
+     **/
+    std::size_t next(const char*& data)
+    {
+        if (!m_has_pending_chunk) {
+            read_chunk();
+        }
+
+        m_has_pending_chunk = false;
+        data = m_buffer.data();
+
+        return m_size;
+    }
+
+  private:
+    void read_chunk()
+    {
+        m_file.read(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+
+        if (m_file.bad()) {
+            throw std::runtime_error{ "Could not read compressed file." };
+        }
+
+        m_size = static_cast<std::size_t>(m_file.gcount());
+        m_has_pending_chunk = true;
+    }
+
+    std::ifstream m_file;
+    std::vector<char> m_buffer;
+    std::size_t m_size = 0;
+    bool m_has_pending_chunk = false;
+};
+
+class passthrough_encoder final : public encoder
+{
+  public:
+    void
+    encode(const char* data, std::size_t size, bool /*finish*/, file_output_stream& sink) override
+    {
+        sink.write(data, size);
+    }
+};
+
+class passthrough_decoder final : public decoder
+{
+  public:
+    explicit passthrough_decoder(file_source& source) noexcept : m_source{ source }
+    {
+    }
+
+    std::size_t decode(char* output, std::size_t capacity) override
+    {
+        std::size_t produced = 0;
+
+        while (produced != capacity) {
+            if (m_available == 0) {
+                m_available = m_source.next(m_data);
+
+                if (m_available == 0) {
+                    break;
+                }
+            }
+
+            const auto count = std::min(capacity - produced, m_available);
+            std::memcpy(output + produced, m_data, count);
+
+            produced += count;
+            m_data += count;
+            m_available -= count;
+        }
+
+        return produced;
+    }
+
+  private:
+    file_source& m_source;
+    const char* m_data = nullptr;
+    std::size_t m_available = 0;
+};
+
+#ifdef JSON_UTILS_HAS_ZLIB
+
+class gzip_encoder final : public encoder
+{
+  public:
+    explicit gzip_encoder(int level) : m_output(compression_buffer_size)
+    {
+        constexpr int gzip_window_bits = 15 + 16;
+
+        if (::deflateInit2(
+                &m_stream, level == 0 ? Z_DEFAULT_COMPRESSION : level, Z_DEFLATED,
+                gzip_window_bits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            throw std::runtime_error{ "Could not initialize gzip compression." };
+        }
+    }
+
+    ~gzip_encoder() override
+    {
+        ::deflateEnd(&m_stream);
+    }
+
+    void encode(const char* data, std::size_t size, bool finish, file_output_stream& sink) override
+    {
+        m_stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+        m_stream.avail_in = static_cast<uInt>(size);
+
+        int result;
+        do {
+            m_stream.next_out = reinterpret_cast<Bytef*>(m_output.data());
+            m_stream.avail_out = static_cast<uInt>(m_output.size());
+
+            result = ::deflate(&m_stream, finish ? Z_FINISH : Z_NO_FLUSH);
+            if (result == Z_STREAM_ERROR) {
+                throw std::runtime_error{ "Could not compress data." };
+            }
+
+            sink.write(m_output.data(), m_output.size() - m_stream.avail_out);
+        } while (m_stream.avail_out == 0 || (finish && result != Z_STREAM_END));
+    }
+
+  private:
+    z_stream m_stream = {};
+    std::vector<char> m_output;
+};
+
+/**
+ * Decompresses both gzip and zlib streams, including files that consist of several concatenated
+ * gzip members.
+ **/
+class gzip_decoder final : public decoder
+{
+  public:
+    explicit gzip_decoder(file_source& source) : m_source{ source }
+    {
+        constexpr int automatic_header_window_bits = 15 + 32;
+
+        if (::inflateInit2(&m_stream, automatic_header_window_bits) != Z_OK) {
+            throw std::runtime_error{ "Could not initialize gzip decompression." };
+        }
+    }
+
+    ~gzip_decoder() override
+    {
+        ::inflateEnd(&m_stream);
+    }
+
+    std::size_t decode(char* output, std::size_t capacity) override
+    {
+        m_stream.next_out = reinterpret_cast<Bytef*>(output);
+        m_stream.avail_out = static_cast<uInt>(capacity);
+
+        while (m_stream.avail_out != 0) {
+            if (m_stream.avail_in == 0) {
+                const char* data;
+                const auto size = m_source.next(data);
+
+                if (size == 0) {
+                    if (m_in_member) {
+                        throw std::runtime_error{ "Unexpected end of compressed data." };
+                    }
+
+                    break;
+                }
+
+                m_stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+                m_stream.avail_in = static_cast<uInt>(size);
+            }
+
+            if (!m_in_member) {
+                ::inflateReset(&m_stream);
+                m_in_member = true;
+            }
+
+            const auto result = ::inflate(&m_stream, Z_NO_FLUSH);
+
+            if (result == Z_STREAM_END) {
+                m_in_member = false;
+            } else if (result != Z_OK && result != Z_BUF_ERROR) {
+                throw std::runtime_error{ "Could not decompress data." };
+            }
+        }
+
+        return capacity - m_stream.avail_out;
+    }
+
+  private:
+    file_source& m_source;
+    z_stream m_stream = {};
+    bool m_in_member = false;
+};
+
+#endif
+
+#ifdef JSON_UTILS_HAS_ZSTD
+
+class zstd_encoder final : public encoder
+{
+  public:
+    explicit zstd_encoder(int level)
+        : m_context{ ::ZSTD_createCCtx() }, m_output(::ZSTD_CStreamOutSize())
+    {
+        if (m_context == nullptr ||
+            ::ZSTD_isError(::ZSTD_CCtx_setParameter(m_context, ZSTD_c_compressionLevel, level))) {
+            ::ZSTD_freeCCtx(m_context);
+            throw std::runtime_error{ "Could not initialize zstd compression." };
+        }
+    }
+
+    ~zstd_encoder() override
+    {
+        ::ZSTD_freeCCtx(m_context);
+    }
+
+    void encode(const char* data, std::size_t size, bool finish, file_output_stream& sink) override
+    {
+        ZSTD_inBuffer input = { data, size, 0 };
+
+        bool done;
+        do {
+            ZSTD_outBuffer output = { m_output.data(), m_output.size(), 0 };
+
+            const auto remaining = ::ZSTD_compressStream2(
+                m_context, &output, &input, finish ? ZSTD_e_end : ZSTD_e_continue);
+
+            if (::ZSTD_isError(remaining)) {
+                throw std::runtime_error{ ::ZSTD_getErrorName(remaining) };
+            }
+
+            sink.write(m_output.data(), output.pos);
+            done = finish ? remaining == 0 : input.pos == input.size;
+        } while (!done);
+    }
+
+  private:
+    ZSTD_CCtx* m_context;
+    std::vector<char> m_output;
+};
+
+class zstd_decoder final : public decoder
+{
+  public:
+    explicit zstd_decoder(file_source& source)
+        : m_source{ source }, m_context{ ::ZSTD_createDCtx() }
+    {
+        if (m_context == nullptr) {
+            throw std::runtime_error{ "Could not initialize zstd decompression." };
+        }
+    }
+
+    ~zstd_decoder() override
+    {
+        ::ZSTD_freeDCtx(m_context);
+    }
+
+    std::size_t decode(char* output, std::size_t capacity) override
+    {
+        ZSTD_outBuffer buffer = { output, capacity, 0 };
+
+        while (buffer.pos != buffer.size) {
+            if (m_input.pos == m_input.size) {
+                const char* data;
+                const auto size = m_source.next(data);
+
+                if (size == 0) {
+                    if (m_frame_remainder != 0) {
+                        throw std::runtime_error{ "Unexpected end of compressed data." };
+                    }
+
+                    break;
+                }
+
+                m_input = { data, size, 0 };
+            }
+
+            m_frame_remainder = ::ZSTD_decompressStream(m_context, &buffer, &m_input);
+
+            if (::ZSTD_isError(m_frame_remainder)) {
+                throw std::runtime_error{ ::ZSTD_getErrorName(m_frame_remainder) };
+            }
+        }
+
+        return buffer.pos;
+    }
+
+  private:
+    file_source& m_source;
+    ZSTD_DCtx* m_context;
+    ZSTD_inBuffer m_input = { nullptr, 0, 0 };
+    std::size_t m_frame_remainder = 0;
+};
+
+#endif
+
+inline std::unique_ptr<encoder> make_encoder(compression_codec codec, int level)
+{
+    switch (codec) {
+        case compression_codec::gzip:
+#ifdef JSON_UTILS_HAS_ZLIB
+            return std::make_unique<gzip_encoder>(level);
+#else
+            throw_codec_unavailable("gzip");
+#endif
+        case compression_codec::zstd:
+#ifdef JSON_UTILS_HAS_ZSTD
+            return std::make_unique<zstd_encoder>(level);
+#else
+            throw_codec_unavailable("zstd");
+#endif
+        default:
+            return std::make_unique<passthrough_encoder>();
+    }
+}
+
+inline std::unique_ptr<decoder> make_decoder(file_source& source)
+{
+    switch (codec_from_magic(source.header(), source.header_size())) {
+        case compression_codec::gzip:
+#ifdef JSON_UTILS_HAS_ZLIB
+            return std::make_unique<gzip_decoder>(source);
+#else
+            throw_codec_unavailable("gzip");
+#endif
+        case compression_codec::zstd:
+#ifdef JSON_UTILS_HAS_ZSTD
+            return std::make_unique<zstd_decoder>(source);
+#else
+            throw_codec_unavailable("zstd");
+#endif
+        default:
+            return std::make_unique<passthrough_decoder>(source);
+    }
+}
+} // namespace detail
+
+/**
+ * An output stream that satisfies rapidjson's `Stream` concept, and that compresses its input
+ * (using gzip or zstd) before writing it to a file through a `file_output_stream`.
+ *
+ * Gzip support requires zlib, and is enabled by defining `JSON_UTILS_HAS_ZLIB`; zstd support
+ * requires libzstd, and is enabled by defining `JSON_UTILS_HAS_ZSTD`. Requesting a codec whose
+ * support isn't enabled throws a `std::runtime_error`, and a path whose extension doesn't identify
+ * the codec throws a `std::invalid_argument`. Either is thrown before the file is opened.
+ *
+ * @note Call `close()` once the serialization is complete, which terminates the compressed stream;
+ * a file that isn't closed is left incomplete (or, if written atomically, isn't written at all).
+ **/
+class compressed_output_stream
+{
+  public:
+    using Ch = char;
+
+    explicit compressed_output_stream(
+        const std::string& path, const compression_options& options = {})
+        : m_encoder{ detail::make_encoder(
+              options.codec == compression_codec::automatic ? detail::codec_from_extension(path)
+                                                            : options.codec,
+              options.level) },
+          m_file{ path, options.file },
+          m_buffer(detail::compression_buffer_size),
+          m_cursor{ m_buffer.data() },
+          m_buffer_end{ m_buffer.data() + m_buffer.size() }
+    {
+    }
+
+#if __cplusplus >= 201703L // C++17
+    explicit compressed_output_stream(
+        const std::filesystem::path& path, const compression_options& options = {})
+        : compressed_output_stream{ detail::path_to_string(path), options }
+    {
+    }
+#endif
+
+    compressed_output_stream(const compressed_output_stream&) = delete;
+    compressed_output_stream& operator=(const compressed_output_stream&) = delete;
+
+    void Put(Ch character)
+    {
+        if (m_cursor == m_buffer_end) {
+            compress_buffer(/* finish = */ false);
+        }
+
+        *m_cursor++ = character;
+    }
+
+    /**
+     * Compressing small pieces of data hurts the compression ratio, so data is only compressed once
+     * the buffer fills up, or once the stream is closed.
+     **/
+    void Flush() noexcept
+    {
+    }
+
+    void write(const Ch* data, std::size_t length)
+    {
+        while (length != 0) {
+            if (m_cursor == m_buffer_end) {
+                compress_buffer(/* finish = */ false);
+            }
+
+            const auto count = std::min(length, static_cast<std::size_t>(m_buffer_end - m_cursor));
+            std::memcpy(m_cursor, data, count);
+
+            m_cursor += count;
+            data += count;
+            length -= count;
+        }
+    }
+
+    /**
+     * Compresses any buffered data, terminates the compressed stream, and closes the file.
+     **/
+    void close()
+    {
+        if (m_closed) {
+            return;
+        }
+
+        compress_buffer(/* finish = */ true);
+        m_file.close();
+
+        m_closed = true;
+    }
+
+  private:
+    void compress_buffer(bool finish)
+    {
+        const auto size = static_cast<std::size_t>(m_cursor - m_buffer.data());
+        m_encoder->encode(m_buffer.data(), size, finish, m_file);
+
+        m_cursor = m_buffer.data();
+    }
+
+    // The encoder is created first, so that an unsupported codec is reported before the file is
+    // created or truncated.
+    std::unique_ptr<detail::encoder> m_encoder;
+    file_output_stream m_file;
+    std::vector<char> m_buffer;
+    char* m_cursor;
+    char* m_buffer_end;
+    bool m_closed = false;
+};
+
+/**
+ * An input stream that satisfies rapidjson's read-only `Stream` concept, and that reads a file that
+ * may be compressed with gzip or zstd, as determined by its magic bytes.
+ *
+ * Decompression runs on a helper thread, which fills one of two buffers while the parser consumes
+ * the other, so that decompression and parsing overlap, and the decompressed document is never held
+ * in memory in its entirety.
+ *
+ * Decompression errors are rethrown on the parsing thread, as a `std::runtime_error`.
+ **/
+class compressed_input_stream
+{
+  public:
+    using Ch = char;
+
+    explicit compressed_input_stream(const std::string& path)
+        : m_source{ path }, m_decoder{ detail::make_decoder(m_source) }
+    {
+        for (auto& buffer : m_buffers) {
+            buffer.data.resize(detail::compression_buffer_size);
+        }
+
+        m_thread = std::thread{ [this] { decompress(); } };
+    }
+
+#if __cplusplus >= 201703L // C++17
+    explicit compressed_input_stream(const std::filesystem::path& path)
+        : compressed_input_stream{ path.string() }
+    {
+    }
+#endif
+
+    compressed_input_stream(const compressed_input_stream&) = delete;
+    compressed_input_stream& operator=(const compressed_input_stream&) = delete;
+
+    ~compressed_input_stream()
+    {
+        {
+            std::lock_guard<std::mutex> lock{ m_mutex };
+            m_stopping = true;
+        }
+
+        m_condition.notify_all();
+        m_thread.join();
+    }
+
+    Ch Peek()
+    {
+        if (RAPIDJSON_UNLIKELY(m_cursor == m_end)) {
+            return next_buffer() ? *m_cursor : '\0';
+        }
+
+        return *m_cursor;
+    }
+
+    Ch Take()
+    {
+        if (RAPIDJSON_UNLIKELY(m_cursor == m_end) && !next_buffer()) {
+            return '\0';
+        }
+
+        return *m_cursor++;
+    }
+
+    std::size_t Tell() const noexcept
+    {
+        return m_consumed + static_cast<std::size_t>(m_cursor - m_begin);
+    }
+
+    Ch* PutBegin()
+    {
+        RAPIDJSON_ASSERT(false);
+        return nullptr;
+    }
+
+    void Put(Ch)
+    {
+        RAPIDJSON_ASSERT(false);
+    }
+
+    void Flush()
+    {
+        RAPIDJSON_ASSERT(false);
+    }
+
+    std::size_t PutEnd(Ch*)
+    {
+        RAPIDJSON_ASSERT(false);
+        return 0;
+    }
+
+  private:
+    struct buffer
+    {
+        std::vector<char> data;
+        std::size_t size = 0;
+        bool is_full = false;
+        bool is_last = false;
+    };
+
+    /**
+     * Runs on the helper thread.
+     **/
+    void decompress()
+    {
+        std::size_t index = 0;
+
+        try {
+            for (;; index ^= 1) {
+                auto& current = m_buffers[index];
+
+                {
+                    std::unique_lock<std::mutex> lock{ m_mutex };
+                    m_condition.wait(lock, [&] { return !current.is_full || m_stopping; });
+
+                    if (m_stopping) {
+                        return;
+                    }
+                }
+
+                const auto size = m_decoder->decode(current.data.data(), current.data.size());
+                const auto is_last = size < current.data.size();
+
+                {
+                    std::lock_guard<std::mutex> lock{ m_mutex };
+                    current.size = size;
+                    current.is_last = is_last;
+                    current.is_full = true;
+                }
+
+                m_condition.notify_all();
+
+                if (is_last) {
+                    return;
+                }
+            }
+        } catch (...) {
+            {
+                std::lock_guard<std::mutex> lock{ m_mutex };
+                m_error = std::current_exception();
+            }
+
+            m_condition.notify_all();
+        }
+    }
+
+    /**
+     * Hands the exhausted buffer back to the helper thread, and waits for the next one.
+     *
+     * @returns False at the end of the data.
+     **/
+    bool next_buffer()
+    {
+        if (m_is_exhausted) {
+            return false;
+        }
+
+        std::unique_lock<std::mutex> lock{ m_mutex };
+
+        if (m_is_holding_buffer) {
+            auto& previous = m_buffers[m_index];
+            m_consumed += previous.size;
+
+            if (previous.is_last) {
+                // The buffer has been counted as consumed, so `Tell()` mustn't count it again.
+                m_begin = m_cursor = m_end;
+                m_is_exhausted = true;
+                return false;
+            }
+
+            previous.is_full = false;
+            m_index ^= 1;
+
+            m_condition.notify_all();
+        }
+
+        auto& current = m_buffers[m_index];
+        m_condition.wait(lock, [&] { return current.is_full || m_error != nullptr; });
+
+        if (!current.is_full) {
+            std::rethrow_exception(m_error);
+        }
+
+        m_is_holding_buffer = true;
+        m_begin = current.data.data();
+        m_cursor = m_begin;
+        m_end = m_begin + current.size;
+
+        return current.size != 0;
+    }
+
+    detail::file_source m_source;
+    std::unique_ptr<detail::decoder> m_decoder;
+
+    buffer m_buffers[2];
+    std::size_t m_index = 0;
+    bool m_is_holding_buffer = false;
+    bool m_is_exhausted = false;
+
+    const char* m_begin = nullptr;
+    const char* m_cursor = nullptr;
+    const char* m_end = nullptr;
+    std::size_t m_consumed = 0;
+
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_stopping = false;
+    std::exception_ptr m_error;
+
+    std::thread m_thread;
+};
+} // namespace json_utils
@@ -0,0 +1,220 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <type_traits>
+
+#include <rapidjson/internal/dtoa.h>
+#include <rapidjson/internal/itoa.h>
+#include <rapidjson/writer.h>
+
+#include "json_serialization_options.h"
+#include "json_serializer.h"
+#include "json_traits.h"
+#include "json_writer.h"
+
+namespace json_utils
+{
+namespace detail
+{
+/**
+ * Writes data whose entire structure is known at compile time (see
+ * `traits::is_directly_serializable`) straight to an output stream. Each level of nesting is
+ * handled by its own overload, which already knows whether it is writing an array, an object, or a
+ * value, so the separators are emitted without the level stack that `rapidjson::Writer<...>`
+ * consults before every value.
+ *
+ * The output is identical to that of a `json_utils::writer<...>` with the same options.
+ **/
+template <typename OutputStreamType> class direct_serializer
+{
+    static_assert(
+        std::is_same<typename OutputStreamType::Ch, char>::value,
+        "Direct serialization requires a narrow character stream.");
+
+  public:
+    direct_serializer(OutputStreamType& stream, const serialization_options& options) noexcept
+        : m_stream{ stream },
+          m_options{ options },
+          m_max_decimal_places{
+              options.numbers.get_style() == number_format::style::max_decimal_places
+                  ? options.numbers.get_decimal_places()
+                  : rapidjson::Writer<OutputStreamType>::kDefaultMaxDecimalPlaces
+          }
+    {
+    }
+
+    void write(bool value)
+    {
+        if (value) {
+            put_range(m_stream, "true", 4);
+        } else {
+            put_range(m_stream, "false", 5);
+        }
+    }
+
+    void write(std::int32_t value)
+    {
+        char buffer[16];
+        write_number(buffer, rapidjson::internal::i32toa(value, buffer));
+    }
+
+    void write(std::uint32_t value)
+    {
+        char buffer[16];
+        write_number(buffer, rapidjson::internal::u32toa(value, buffer));
+    }
+
+    void write(std::int64_t value)
+    {
+        char buffer[32];
+        write_number(buffer, rapidjson::internal::i64toa(value, buffer));
+    }
+
+    void write(std::uint64_t value)
+    {
+        char buffer[32];
+        write_number(buffer, rapidjson::internal::u64toa(value, buffer));
+    }
+
+    void write(double value)
+    {
+        if (m_options.numbers.get_style() == number_format::style::fixed && std::isfinite(value)) {
+            const auto decimal_places = m_options.numbers.get_decimal_places();
+
+            char buffer[number_buffer_size];
+            write_number(buffer, format_fixed(value, decimal_places, buffer));
+
+            return;
+        }
+
+        write_shortest(value);
+    }
+
+    /**
+     * @note Mirrors `writer_adaptor<...>::Float(...)`.
+     **/
+    void write(float value)
+    {
+        if (!std::isfinite(value)) {
+            write_shortest(static_cast<double>(value));
+            return;
+        }
+
+        switch (m_options.numbers.get_style()) {
+            case number_format::style::fixed:
+                write(static_cast<double>(value));
+                return;
+            case number_format::style::max_decimal_places:
+                write_shortest(widen_shortest(value));
+                return;
+            case number_format::style::shortest: {
+                char buffer[number_buffer_size];
+                write_number(buffer, format_shortest(value, buffer));
+
+                return;
+            }
+            default:
+                write_shortest(static_cast<double>(value));
+        }
+    }
+
+    void write(const std::string& value)
+    {
+        write_escaped_string(m_stream, value.data(), value.size());
+    }
+
+    template <typename ContainerType>
+    auto write(const ContainerType& container)
+        -> std::enable_if_t<traits::treat_as_array_sink_v<ContainerType>>
+    {
+        using std::begin;
+        using std::end;
+
+        m_stream.Put('[');
+
+        auto position = begin(container);
+        const auto last = end(container);
+
+        if (position != last) {
+            write(*position);
+
+            for (++position; position != last; ++position) {
+                m_stream.Put(',');
+                write(*position);
+            }
+        }
+
+        m_stream.Put(']');
+    }
+
+    template <typename ContainerType>
+    auto write(const ContainerType& container)
+        -> std::enable_if_t<traits::treat_as_object_sink_v<ContainerType>>
+    {
+        m_stream.Put('{');
+
+        bool is_first = true;
+
+        for (const auto& member : container) {
+            if (serializer::detail::is_omitted_member(m_options, member.second)) {
+                continue;
+            }
+
+            if (!is_first) {
+                m_stream.Put(',');
+            }
+
+            is_first = false;
+
+            write_key(member.first);
+            m_stream.Put(':');
+            write(member.second);
+        }
+
+        m_stream.Put('}');
+    }
+
+  private:
+    void write_key(const std::string& key)
+    {
+        const auto* const alias =
+            m_options.key_aliases == nullptr ? nullptr
+                                             : m_options.key_aliases->find(key.data(), key.size());
+
+        if (alias != nullptr) {
+            write_escaped_string(m_stream, alias->data(), alias->size());
+        } else {
+            write_escaped_string(m_stream, key.data(), key.size());
+        }
+    }
+
+    /**
+     * @note Like `rapidjson::Writer<...>`, which rejects NaN and infinity, nothing is written for
+     * such values.
+     **/
+    void write_shortest(double value)
+    {
+        if (!std::isfinite(value)) {
+            return;
+        }
+
+        char buffer[number_buffer_size];
+        write_number(buffer, rapidjson::internal::dtoa(value, buffer, m_max_decimal_places));
+    }
+
+    void write_number(const char* begin, const char* end)
+    {
+        put_range(m_stream, begin, static_cast<std::size_t>(end - begin));
+    }
+
+    OutputStreamType& m_stream;
+    const serialization_options& m_options;
+
+    int m_max_decimal_places;
+};
+} // namespace detail
+} // namespace json_utils
@@ -2,7 +2,13 @@
 
 #include "json_fwd.h"
 
+#include <limits>
 #include <stdexcept>
+#include <type_traits>
+
+#if __cplusplus >= 201703L // C++17
+#include <charconv>
+#endif
 
 namespace json_utils
 {
@@ -313,6 +319,103 @@ template <typename DataType> struct value_extractor<std::optional<DataType>>
 
 #endif
 
+[[noreturn]] inline void throw_invalid_integer_key()
+{
+    throw std::invalid_argument{ "Expected a key that holds an integer within range." };
+}
+
+/**
+ * Parses the digits of an integer key, which may only be preceded by a minus sign.
+ **/
+template <typename IntegerType, typename CharacterType>
+IntegerType parse_integer_key(const CharacterType* data, std::size_t length)
+{
+    using unsigned_type = std::make_unsigned_t<IntegerType>;
+
+    const auto* cursor = data;
+    const auto* const end = data + length;
+
+    const bool is_negative = std::is_signed<IntegerType>::value && cursor != end && *cursor == '-';
+    if (is_negative) {
+        ++cursor;
+    }
+
+    if (RAPIDJSON_UNLIKELY(cursor == end)) {
+        throw_invalid_integer_key();
+    }
+
+    const auto maximum = static_cast<unsigned_type>(std::numeric_limits<IntegerType>::max());
+    const auto limit = static_cast<unsigned_type>(maximum + (is_negative ? 1 : 0));
+
+    unsigned_type magnitude = 0;
+
+    for (; cursor != end; ++cursor) {
+        if (RAPIDJSON_UNLIKELY(*cursor < '0' || *cursor > '9')) {
+            throw_invalid_integer_key();
+        }
+
+        const auto digit = static_cast<unsigned_type>(*cursor - '0');
+        if (RAPIDJSON_UNLIKELY(magnitude > (limit - digit) / 10)) {
+            throw_invalid_integer_key();
+        }
+
+        magnitude = static_cast<unsigned_type>(magnitude * 10 + digit);
+    }
+
+    if (is_negative && magnitude != 0) {
+        return static_cast<IntegerType>(-static_cast<IntegerType>(magnitude - 1) - 1);
+    }
+
+    return static_cast<IntegerType>(magnitude);
+}
+
+#if __cplusplus >= 201703L // C++17
+
+template <typename IntegerType>
+IntegerType parse_integer_key(const char* data, std::size_t length)
+{
+    IntegerType value;
+    const auto result = std::from_chars(data, data + length, value);
+
+    if (RAPIDJSON_UNLIKELY(result.ec != std::errc{} || result.ptr != data + length)) {
+        throw_invalid_integer_key();
+    }
+
+    return value;
+}
+
+#endif
+
+/**
+ * Extracts the key of an object member, which, unlike a value, is always stored as a string.
+ **/
+template <typename KeyType, typename = void> struct key_extractor : value_extractor<KeyType>
+{
+};
+
+template <typename KeyType>
+struct key_extractor<KeyType, std::enable_if_t<traits::is_integer_key_v<KeyType>>>
+{
+    template <typename EncodingType, typename AllocatorType>
+    static KeyType extract_or_throw(const rapidjson::GenericValue<EncodingType, AllocatorType>& key)
+    {
+        return parse_integer_key<KeyType>(key.GetString(), key.GetStringLength());
+    }
+};
+
+template <typename KeyType>
+struct key_extractor<KeyType, std::enable_if_t<std::is_enum<KeyType>::value>>
+{
+    template <typename EncodingType, typename AllocatorType>
+    static KeyType extract_or_throw(const rapidjson::GenericValue<EncodingType, AllocatorType>& key)
+    {
+        using underlying_type = std::underlying_type_t<KeyType>;
+
+        return static_cast<KeyType>(
+            parse_integer_key<underlying_type>(key.GetString(), key.GetStringLength()));
+    }
+};
+
 template <typename DataType, typename ContainerType>
 auto insert(DataType&& value, ContainerType& container)
     -> std::enable_if_t<traits::has_emplace_v<ContainerType>>
@@ -350,7 +453,7 @@ PairType construct_nested_pair(const rapidjson::GenericMember<EncodingType, Allo
     nested_type container;
     dom_deserializer::from_json(member.value, container);
 
-    return { value_extractor<key_type>::extract_or_throw(member.name), std::move(container) };
+    return { key_extractor<key_type>::extract_or_throw(member.name), std::move(container) };
 }
 
 template <typename PairType, typename EncodingType, typename AllocatorType>
@@ -360,7 +463,7 @@ auto to_key_value_pair(const rapidjson::GenericMember<EncodingType, AllocatorTyp
     using key_type = typename std::decay<typename PairType::first_type>::type;
     using value_type = typename PairType::second_type;
 
-    return { value_extractor<key_type>::extract_or_throw(member.name),
+    return { key_extractor<key_type>::extract_or_throw(member.name),
              value_extractor<value_type>::extract_or_throw(member.value) };
 }
 
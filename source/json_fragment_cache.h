@@ -0,0 +1,346 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+#include <rapidjson/rapidjson.h>
+
+#include "json_output_streams.h"
+#include "json_serialization_options.h"
+#include "json_serializer.h"
+#include "json_writer.h"
+
+namespace json_utils
+{
+/**
+ * Retains the serialized form of `cached_fragment<...>` instances across calls, so that fragments
+ * that haven't changed since they were last serialized are spliced into the output as they are.
+ *
+ * The cache holds on to at most `capacity` bytes of JSON; once full, the least recently used
+ * fragments are evicted. Fragments that are larger than the entire cache are never retained.
+ *
+ * @note The cache may be shared by several threads, and must outlive the fragments that use it.
+ **/
+class fragment_cache
+{
+  public:
+    explicit fragment_cache(std::size_t capacity) noexcept : m_capacity{ capacity }
+    {
+    }
+
+    fragment_cache(const fragment_cache&) = delete;
+    fragment_cache& operator=(const fragment_cache&) = delete;
+
+    /**
+     * @returns The serialized fragment, or null if the given version of the fragment isn't cached,
+     * or was serialized using different options.
+     **/
+    std::shared_ptr<const std::string> find(
+        std::uint64_t id, std::uint64_t version, const serialization_options& options)
+    {
+        const std::lock_guard<std::mutex> lock{ m_mutex };
+
+        const auto match = m_index.find(id);
+        if (match == m_index.end()) {
+            ++m_misses;
+            return nullptr;
+        }
+
+        const auto entry = match->second;
+        if (entry->version != version || !have_same_format(entry->options, options)) {
+            erase(entry);
+            ++m_misses;
+            return nullptr;
+        }
+
+        m_entries.splice(m_entries.begin(), m_entries, entry);
+        ++m_hits;
+
+        return entry->json;
+    }
+
+    void insert(
+        std::uint64_t id, std::uint64_t version, const serialization_options& options,
+        std::shared_ptr<const std::string> json)
+    {
+        const std::lock_guard<std::mutex> lock{ m_mutex };
+
+        const auto match = m_index.find(id);
+        if (match != m_index.end()) {
+            erase(match->second);
+        }
+
+        if (json->size() > m_capacity) {
+            return;
+        }
+
+        while (m_size + json->size() > m_capacity) {
+            erase(std::prev(m_entries.end()));
+        }
+
+        m_size += json->size();
+        m_entries.push_front({ id, version, options, std::move(json) });
+        m_index.emplace(id, m_entries.begin());
+    }
+
+    /**
+     * Drops the cached form of a single fragment.
+     **/
+    void invalidate(std::uint64_t id)
+    {
+        const std::lock_guard<std::mutex> lock{ m_mutex };
+
+        const auto match = m_index.find(id);
+        if (match != m_index.end()) {
+            erase(match->second);
+        }
+    }
+
+    /**
+     * Drops every cached fragment.
+     **/
+    void clear()
+    {
+        const std::lock_guard<std::mutex> lock{ m_mutex };
+
+        m_entries.clear();
+        m_index.clear();
+        m_size = 0;
+    }
+
+    std::size_t capacity() const noexcept
+    {
+        return m_capacity;
+    }
+
+    /**
+     * @returns The number of bytes of JSON that are currently cached.
+     **/
+    std::size_t size() const
+    {
+        const std::lock_guard<std::mutex> lock{ m_mutex };
+        return m_size;
+    }
+
+    std::size_t hits() const
+    {
+        const std::lock_guard<std::mutex> lock{ m_mutex };
+        return m_hits;
+    }
+
+    std::size_t misses() const
+    {
+        const std::lock_guard<std::mutex> lock{ m_mutex };
+        return m_misses;
+    }
+
+  private:
+    struct entry
+    {
+        std::uint64_t id;
+        std::uint64_t version;
+        serialization_options options;
+        std::shared_ptr<const std::string> json;
+    };
+
+    using entry_iterator = std::list<entry>::iterator;
+
+    static bool
+    have_same_format(const serialization_options& lhs, const serialization_options& rhs) noexcept
+    {
+        return lhs.numbers.get_style() == rhs.numbers.get_style() &&
+               lhs.numbers.get_decimal_places() == rhs.numbers.get_decimal_places() &&
+               lhs.omit_null_members == rhs.omit_null_members &&
+               lhs.omit_default_members == rhs.omit_default_members &&
+               lhs.key_aliases == rhs.key_aliases;
+    }
+
+    void erase(entry_iterator position)
+    {
+        m_size -= position->json->size();
+        m_index.erase(position->id);
+        m_entries.erase(position);
+    }
+
+    mutable std::mutex m_mutex;
+
+    std::list<entry> m_entries;
+    std::unordered_map<std::uint64_t, entry_iterator> m_index;
+
+    std::size_t m_capacity;
+    std::size_t m_size = 0;
+
+    std::size_t m_hits = 0;
+    std::size_t m_misses = 0;
+};
+
+namespace detail
+{
+inline std::uint64_t next_fragment_id() noexcept
+{
+    static std::atomic<std::uint64_t> counter{ 0 };
+    return ++counter;
+}
+} // namespace detail
+
+/**
+ * Wraps a part of a larger document whose serialized form is cached in a `fragment_cache`, such
+ * that it is only serialized again once it has been modified:
+ *
+ * @code
+ * json_utils::fragment_cache cache{ 64 * 1024 * 1024 };
+ * std::vector<json_utils::cached_fragment<product>> catalog = ...;
+ *
+ * catalog[42].modify().price = 10;
+ * const auto json = json_utils::serialize_to_json(catalog);
+ * @endcode
+ *
+ * Every call to `modify()` marks the fragment as changed, so that the next serialization
+ * refreshes its entry in the cache.
+ *
+ * @note Fragments are always spliced in compact form, and are written out as usual by pretty
+ * writers, and by writers that can't splice raw JSON.
+ **/
+template <typename DataType> class cached_fragment
+{
+  public:
+    cached_fragment(fragment_cache& cache, DataType data)
+        : m_data{ std::move(data) }, m_cache{ &cache }
+    {
+    }
+
+    /**
+     * A copy may be modified independently of the original, and is therefore cached separately.
+     **/
+    cached_fragment(const cached_fragment& other)
+        : m_data{ other.m_data }, m_cache{ other.m_cache }
+    {
+    }
+
+    cached_fragment(cached_fragment&& other) noexcept(
+        std::is_nothrow_move_constructible<DataType>::value)
+        : m_data{ std::move(other.m_data) },
+          m_cache{ other.m_cache },
+          m_id{ other.m_id },
+          m_version{ other.m_version }
+    {
+        other.m_id = detail::next_fragment_id();
+    }
+
+    cached_fragment& operator=(const cached_fragment& other)
+    {
+        m_data = other.m_data;
+        m_cache = other.m_cache;
+        ++m_version;
+
+        return *this;
+    }
+
+    cached_fragment& operator=(cached_fragment&& other) noexcept(
+        std::is_nothrow_move_assignable<DataType>::value)
+    {
+        m_data = std::move(other.m_data);
+        m_cache = other.m_cache;
+        ++m_version;
+
+        return *this;
+    }
+
+    const DataType& get() const noexcept
+    {
+        return m_data;
+    }
+
+    /**
+     * @returns Mutable access to the wrapped data, which is assumed to change.
+     **/
+    DataType& modify() noexcept
+    {
+        ++m_version;
+        return m_data;
+    }
+
+    /**
+     * Marks the fragment as changed, for when it depends on state beyond the wrapped data.
+     **/
+    void invalidate() noexcept
+    {
+        ++m_version;
+    }
+
+    fragment_cache& cache() const noexcept
+    {
+        return *m_cache;
+    }
+
+    std::uint64_t id() const noexcept
+    {
+        return m_id;
+    }
+
+    std::uint64_t version() const noexcept
+    {
+        return m_version;
+    }
+
+  private:
+    DataType m_data;
+    fragment_cache* m_cache;
+
+    std::uint64_t m_id = detail::next_fragment_id();
+    std::uint64_t m_version = 0;
+};
+
+namespace serializer
+{
+namespace detail
+{
+template <typename WriterType, typename DataType>
+void write_fragment(WriterType& writer, const cached_fragment<DataType>& fragment, std::false_type)
+{
+    to_json(writer, fragment.get());
+}
+
+template <typename WriterType, typename DataType>
+void write_fragment(WriterType& writer, const cached_fragment<DataType>& fragment, std::true_type)
+{
+    auto& cache = fragment.cache();
+    const auto options = options_of(writer);
+
+    auto json = cache.find(fragment.id(), fragment.version(), options);
+    if (json == nullptr) {
+        // The fragment outlives this document, so it mustn't refer to the objects written in it.
+        auto fragment_options = options;
+        if (fragment_options.shared_pointers == shared_pointer_policy::reference) {
+            fragment_options.shared_pointers = shared_pointer_policy::memoize;
+        }
+
+        string_output_stream<> stream;
+        json_utils::writer<string_output_stream<>> fragment_writer{ stream };
+        fragment_writer.set_options(fragment_options);
+
+        to_json(fragment_writer, fragment.get());
+
+        json = std::make_shared<const std::string>(stream.release());
+        cache.insert(fragment.id(), fragment.version(), options, json);
+    }
+
+    writer.RawValue(json->data(), json->size(), rapidjson::kObjectType);
+}
+
+template <typename WriterType, typename DataType>
+void to_json(WriterType& writer, const cached_fragment<DataType>& fragment)
+{
+    write_fragment(writer, fragment, can_splice_raw_json<WriterType>{});
+}
+} // namespace detail
+} // namespace serializer
+} // namespace json_utils
@@ -21,6 +21,25 @@
 
 namespace json_utils
 {
+class trusted_ascii;
+
+class stable_string;
+
+template <typename RangeType> class array_range;
+
+template <typename RangeType, typename KeyProjectionType, typename ValueProjectionType>
+class object_range;
+
+template <typename GeneratorType> class generated_array;
+
+template <typename GeneratorType> class generated_object;
+
+template <typename RangeType> class columnar_range;
+
+template <typename DataType> class cached_fragment;
+
+class raw_json;
+
 namespace serializer
 {
 namespace detail
@@ -47,6 +66,10 @@ template <typename WriterType> void to_json(WriterType& writer, const char* data
 
 template <typename WriterType> void to_json(WriterType& writer, const wchar_t* data);
 
+template <typename WriterType> void to_json(WriterType& writer, const trusted_ascii& data);
+
+template <typename WriterType> void to_json(WriterType& writer, const stable_string& data);
+
 template <typename WriterType, typename DataType>
 void to_json(WriterType& writer, const std::shared_ptr<DataType>& pointer);
 
@@ -67,6 +90,30 @@ auto to_json(WriterType& writer, const ContainerType& container)
 template <typename WriterType, typename FirstType, typename SecondType>
 void to_json(WriterType& writer, const std::pair<FirstType, SecondType>& pair);
 
+template <typename WriterType, typename RangeType>
+void to_json(WriterType& writer, const array_range<RangeType>& data);
+
+template <
+    typename WriterType, typename RangeType, typename KeyProjectionType,
+    typename ValueProjectionType>
+void to_json(
+    WriterType& writer,
+    const object_range<RangeType, KeyProjectionType, ValueProjectionType>& data);
+
+template <typename WriterType, typename GeneratorType>
+void to_json(WriterType& writer, const generated_array<GeneratorType>& data);
+
+template <typename WriterType, typename GeneratorType>
+void to_json(WriterType& writer, const generated_object<GeneratorType>& data);
+
+template <typename WriterType, typename RangeType>
+void to_json(WriterType& writer, const columnar_range<RangeType>& data);
+
+template <typename WriterType, typename DataType>
+void to_json(WriterType& writer, const cached_fragment<DataType>& fragment);
+
+template <typename WriterType> void to_json(WriterType& writer, const raw_json& data);
+
 #if __cplusplus >= 201703L // C++17
 
 template <typename WriterType, typename CharacterType, typename CharacterTraits>
@@ -0,0 +1,420 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <rapidjson/rapidjson.h>
+
+namespace json_utils
+{
+namespace detail
+{
+/**
+ * An incremental implementation of the 64-bit xxHash algorithm (XXH64), which produces the same
+ * digests as the reference implementation, regardless of how the input is split across updates.
+ **/
+class xxh64
+{
+  public:
+    explicit xxh64(std::uint64_t seed = 0) noexcept
+        : m_accumulators{ seed + prime_1 + prime_2, seed + prime_2, seed, seed - prime_1 },
+          m_seed{ seed }
+    {
+    }
+
+    void update(const void* data, std::size_t size) noexcept
+    {
+        if (size == 0) {
+            return;
+        }
+
+        const auto* input = static_cast<const std::uint8_t*>(data);
+        m_total_size += size;
+
+        if (m_buffered + size < stripe_size) {
+            std::memcpy(m_buffer + m_buffered, input, size);
+            m_buffered += size;
+            return;
+        }
+
+        if (m_buffered != 0) {
+            const auto fill = stripe_size - m_buffered;
+            std::memcpy(m_buffer + m_buffered, input, fill);
+            consume_stripe(m_buffer);
+
+            input += fill;
+            size -= fill;
+            m_buffered = 0;
+        }
+
+        for (; size >= stripe_size; input += stripe_size, size -= stripe_size) {
+            consume_stripe(input);
+        }
+
+        std::memcpy(m_buffer, input, size);
+        m_buffered = size;
+    }
+
+    std::uint64_t digest() const noexcept
+    {
+        std::uint64_t hash;
+
+        if (m_total_size >= stripe_size) {
+            hash = rotate_left(m_accumulators[0], 1) + rotate_left(m_accumulators[1], 7) +
+                   rotate_left(m_accumulators[2], 12) + rotate_left(m_accumulators[3], 18);
+
+            for (const auto accumulator : m_accumulators) {
+                hash = merge_round(hash, accumulator);
+            }
+        } else {
+            hash = m_seed + prime_5;
+        }
+
+        hash += m_total_size;
+
+        const auto* input = m_buffer;
+        auto remaining = m_buffered;
+
+        for (; remaining >= 8; input += 8, remaining -= 8) {
+            hash ^= round(0, read_little_endian(input, 8));
+            hash = rotate_left(hash, 27) * prime_1 + prime_4;
+        }
+
+        if (remaining >= 4) {
+            hash ^= read_little_endian(input, 4) * prime_1;
+            hash = rotate_left(hash, 23) * prime_2 + prime_3;
+
+            input += 4;
+            remaining -= 4;
+        }
+
+        for (; remaining > 0; ++input, --remaining) {
+            hash ^= *input * prime_5;
+            hash = rotate_left(hash, 11) * prime_1;
+        }
+
+        hash ^= hash >> 33;
+        hash *= prime_2;
+        hash ^= hash >> 29;
+        hash *= prime_3;
+        hash ^= hash >> 32;
+
+        return hash;
+    }
+
+  private:
+    static constexpr std::uint64_t prime_1 = 0x9E3779B185EBCA87ULL;
+    static constexpr std::uint64_t prime_2 = 0xC2B2AE3D27D4EB4FULL;
+    static constexpr std::uint64_t prime_3 = 0x165667B19E3779F9ULL;
+    static constexpr std::uint64_t prime_4 = 0x85EBCA77C2B2AE63ULL;
+    static constexpr std::uint64_t prime_5 = 0x27D4EB2F165667C5ULL;
+
+    static constexpr std::size_t stripe_size = 32;
+
+    static std::uint64_t rotate_left(std::uint64_t value, int bits) noexcept
+    {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    static std::uint64_t round(std::uint64_t accumulator, std::uint64_t input) noexcept
+    {
+        accumulator += input * prime_2;
+        return rotate_left(accumulator, 31) * prime_1;
+    }
+
+    static std::uint64_t merge_round(std::uint64_t hash, std::uint64_t accumulator) noexcept
+    {
+        hash ^= round(0, accumulator);
+        return hash * prime_1 + prime_4;
+    }
+
+    static std::uint64_t read_little_endian(const std::uint8_t* input, std::size_t size) noexcept
+    {
+        std::uint64_t value = 0;
+        for (std::size_t index = 0; index < size; ++index) {
+            value |= static_cast<std::uint64_t>(input[index]) << (8 * index);
+        }
+
+        return value;
+    }
+
+    void consume_stripe(const std::uint8_t* input) noexcept
+    {
+        for (std::size_t lane = 0; lane < 4; ++lane) {
+            m_accumulators[lane] =
+                round(m_accumulators[lane], read_little_endian(input + 8 * lane, 8));
+        }
+    }
+
+    std::uint64_t m_accumulators[4];
+    std::uint64_t m_seed;
+    std::uint64_t m_total_size = 0;
+
+    std::uint8_t m_buffer[stripe_size];
+    std::size_t m_buffered = 0;
+};
+} // namespace detail
+
+struct hash_options
+{
+    /**
+     * Makes the hash of an object independent of the order in which its members are written, so
+     * that, for instance, two `std::unordered_map<...>` instances with the same contents always
+     * hash alike.
+     **/
+    bool sort_keys = false;
+
+    std::uint64_t seed = 0;
+};
+
+/**
+ * A writer that implements the same handler interface as `rapidjson::Writer<...>`, but that feeds a
+ * canonical, binary encoding of the document into an XXH64 hash instead of producing any text.
+ * Any type that can be serialized to JSON can therefore be hashed, without allocating the JSON.
+ *
+ * The encoding tags every value with its type, and length-prefixes every string, so that distinct
+ * documents can't produce the same input to the hash. Integers hash alike, regardless of the
+ * handler that reports them (e.g., `Int(1)` and `Uint64(1)`), just like they serialize alike.
+ *
+ * With `hash_options::sort_keys`, every member of an object is hashed on its own, and the digests
+ * of the members are summed, which makes the result independent of their order.
+ *
+ * @note The digest is only stable within the same major version of this library, and is not the
+ * XXH64 digest of the JSON text.
+ **/
+class hash_writer
+{
+  public:
+    using Ch = char;
+
+    /**
+     * Raw values would be hashed as opaque text, so that differently formatted, or differently
+     * ordered, JSON would hash differently. Cached fragments are therefore hashed from the data
+     * that they wrap instead, and `raw_json` values from the values that their text is parsed into.
+     **/
+    static constexpr bool accepts_raw_json = false;
+
+    explicit hash_writer(const hash_options& options = {}) : m_options{ options }
+    {
+        m_states.emplace_back(m_options.seed);
+    }
+
+    /**
+     * Prepares the writer for another document, while retaining its allocations.
+     **/
+    void Reset()
+    {
+        m_states.clear();
+        m_states.emplace_back(m_options.seed);
+        m_frames.clear();
+    }
+
+    /**
+     * @returns The digest of everything that has been written so far.
+     **/
+    std::uint64_t digest() const noexcept
+    {
+        return m_states.front().digest();
+    }
+
+    bool Null()
+    {
+        put_tag(null_tag);
+        end_value();
+        return true;
+    }
+
+    bool Bool(bool value)
+    {
+        put_tag(value ? true_tag : false_tag);
+        end_value();
+        return true;
+    }
+
+    bool Int(int value)
+    {
+        return Int64(value);
+    }
+
+    bool Uint(unsigned value)
+    {
+        return Uint64(value);
+    }
+
+    bool Int64(std::int64_t value)
+    {
+        if (value >= 0) {
+            return Uint64(static_cast<std::uint64_t>(value));
+        }
+
+        put_tagged_integer(negative_integer_tag, static_cast<std::uint64_t>(value));
+        end_value();
+        return true;
+    }
+
+    bool Uint64(std::uint64_t value)
+    {
+        put_tagged_integer(unsigned_integer_tag, value);
+        end_value();
+        return true;
+    }
+
+    bool Double(double value)
+    {
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof bits);
+
+        put_tagged_integer(double_tag, bits);
+        end_value();
+        return true;
+    }
+
+    bool String(const Ch* data, rapidjson::SizeType length, bool /*copy*/ = false)
+    {
+        put_tagged_bytes(string_tag, data, length);
+        end_value();
+        return true;
+    }
+
+    bool String(const Ch* data)
+    {
+        return String(data, static_cast<rapidjson::SizeType>(std::strlen(data)));
+    }
+
+    bool RawValue(const Ch* data, std::size_t length, rapidjson::Type /*type*/)
+    {
+        put_tagged_bytes(raw_tag, data, length);
+        end_value();
+        return true;
+    }
+
+    bool Key(const Ch* data, rapidjson::SizeType length, bool /*copy*/ = false)
+    {
+        auto& object = m_frames.back();
+        ++object.count;
+
+        if (object.is_sorted) {
+            m_states.emplace_back(m_options.seed);
+        }
+
+        put_tagged_bytes(key_tag, data, length);
+        return true;
+    }
+
+    bool Key(const Ch* data)
+    {
+        return Key(data, static_cast<rapidjson::SizeType>(std::strlen(data)));
+    }
+
+    bool StartObject()
+    {
+        put_tag(start_object_tag);
+        m_frames.push_back({ /* is_sorted = */ m_options.sort_keys, 0, 0 });
+        return true;
+    }
+
+    bool EndObject(rapidjson::SizeType /*member_count*/ = 0)
+    {
+        const auto object = m_frames.back();
+        m_frames.pop_back();
+
+        if (object.is_sorted) {
+            put_tagged_integer(member_sum_tag, object.member_sum);
+            put_tagged_integer(member_count_tag, object.count);
+        }
+
+        put_tag(end_object_tag);
+        end_value();
+        return true;
+    }
+
+    bool StartArray()
+    {
+        put_tag(start_array_tag);
+        m_frames.push_back({ /* is_sorted = */ false, 0, 0 });
+        return true;
+    }
+
+    bool EndArray(rapidjson::SizeType /*element_count*/ = 0)
+    {
+        m_frames.pop_back();
+
+        put_tag(end_array_tag);
+        end_value();
+        return true;
+    }
+
+  private:
+    enum tag : std::uint8_t
+    {
+        null_tag = 'n',
+        false_tag = 'f',
+        true_tag = 't',
+        unsigned_integer_tag = 'u',
+        negative_integer_tag = 'i',
+        double_tag = 'd',
+        string_tag = 's',
+        raw_tag = 'r',
+        key_tag = 'k',
+        start_object_tag = '{',
+        end_object_tag = '}',
+        start_array_tag = '[',
+        end_array_tag = ']',
+        member_sum_tag = 'S',
+        member_count_tag = 'C'
+    };
+
+    /**
+     * An open container. The members of a sorted object are hashed separately, and only the sum of
+     * their digests is fed into the hash of the enclosing value.
+     **/
+    struct frame
+    {
+        bool is_sorted;
+        std::uint64_t member_sum;
+        std::uint64_t count;
+    };
+
+    void put_tag(tag value) noexcept
+    {
+        const auto byte = static_cast<std::uint8_t>(value);
+        m_states.back().update(&byte, 1);
+    }
+
+    void put_tagged_integer(tag value, std::uint64_t integer) noexcept
+    {
+        std::uint8_t bytes[9] = { static_cast<std::uint8_t>(value) };
+        for (std::size_t index = 0; index < 8; ++index) {
+            bytes[index + 1] = static_cast<std::uint8_t>(integer >> (8 * index));
+        }
+
+        m_states.back().update(bytes, sizeof bytes);
+    }
+
+    void put_tagged_bytes(tag value, const Ch* data, std::size_t length) noexcept
+    {
+        put_tagged_integer(value, length);
+        m_states.back().update(data, length);
+    }
+
+    /**
+     * Completes the member of a sorted object, once its value has been written in its entirety.
+     **/
+    void end_value() noexcept
+    {
+        if (m_frames.empty() || !m_frames.back().is_sorted) {
+            return;
+        }
+
+        m_frames.back().member_sum += m_states.back().digest();
+        m_states.pop_back();
+    }
+
+    hash_options m_options;
+
+    std::vector<detail::xxh64> m_states;
+    std::vector<frame> m_frames;
+};
+} // namespace json_utils
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+
+#include "json_output_streams.h"
+#include "json_serialization_options.h"
+#include "json_serializer.h"
+#include "json_writer.h"
+
+namespace json_utils
+{
+/**
+ * Writes records in the JSON Lines (or NDJSON) format: each record is serialized as a compact JSON
+ * document, using the same `to_json(...)` customization point as `serialize_to_json(...)`, and is
+ * followed by a newline.
+ *
+ * All records are written through a single writer into the same output stream, so no string is
+ * allocated per record, and the stream's own buffering determines how often data is handed off.
+ * With a `file_output_stream`, for instance, the records are written out in batches the size of the
+ * file buffer.
+ *
+ * @note The writer refers to the output stream, which must outlive it. Call `flush()` once all
+ * records have been written (or `close()` on a `file_output_stream`). If serializing a record
+ * throws, the output is left with a partial line.
+ **/
+template <typename OutputStreamType> class json_lines_writer
+{
+    static_assert(
+        std::is_same<typename OutputStreamType::Ch, char>::value,
+        "JSON Lines output requires a narrow character stream.");
+
+  public:
+    using Ch = typename OutputStreamType::Ch;
+
+    explicit json_lines_writer(
+        OutputStreamType& stream, const serialization_options& options = {})
+        : m_stream{ stream }, m_writer{ m_stream }
+    {
+        m_writer.set_options(options);
+    }
+
+    json_lines_writer(const json_lines_writer&) = delete;
+    json_lines_writer& operator=(const json_lines_writer&) = delete;
+
+    /**
+     * Appends a single record, followed by a newline.
+     **/
+    template <typename DataType> void write(const DataType& record)
+    {
+        m_writer.Reset(m_stream);
+        serializer::to_json(m_writer, record);
+
+        m_stream.Put(static_cast<Ch>('\n'));
+        ++m_record_count;
+    }
+
+    /**
+     * Appends every record in the range, in order.
+     **/
+    template <typename RangeType> void write_all(const RangeType& records)
+    {
+        for (const auto& record : records) {
+            write(record);
+        }
+    }
+
+    /**
+     * Flushes the underlying output stream.
+     **/
+    void flush()
+    {
+        m_stream.underlying().Flush();
+    }
+
+    /**
+     * @returns The number of records written so far.
+     **/
+    std::size_t record_count() const noexcept
+    {
+        return m_record_count;
+    }
+
+  private:
+    detail::deferred_flush_stream<OutputStreamType> m_stream;
+    json_utils::writer<detail::deferred_flush_stream<OutputStreamType>> m_writer;
+    std::size_t m_record_count = 0;
+};
+} // namespace json_utils
@@ -0,0 +1,248 @@
+#pragma once
+
+#include "json_output_streams.h"
+
+#ifdef JSON_UTILS_POSIX_FILES
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+#if __cplusplus >= 201703L // C++17
+#include <filesystem>
+#endif
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define JSON_UTILS_MEMORY_MAPPED_FILES
+
+namespace json_utils
+{
+namespace detail
+{
+inline std::size_t page_size() noexcept
+{
+    static const auto size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+/**
+ * @returns True if the error indicates that the file can't be written through a memory mapping
+ * (e.g., because it isn't a regular file, or because the filesystem doesn't support mapping), in
+ * which case it should be written using regular `write(2)` calls instead.
+ **/
+inline bool is_mapping_unsupported(int error) noexcept
+{
+    return error == ENODEV || error == ENOTSUP || error == EOPNOTSUPP || error == EINVAL ||
+           error == ENOMEM;
+}
+} // namespace detail
+
+/**
+ * An output stream that satisfies rapidjson's `Stream` concept and writes straight into a shared
+ * memory mapping of the output file, so that the data is only ever copied into the page cache
+ * once.
+ *
+ * The file is grown, and mapped, one extent at a time. On Linux, each extent is preallocated with
+ * `fallocate(...)`, so that running out of disk space is reported as an error, rather than as a
+ * `SIGBUS` when the page is first touched; on filesystems without preallocation support (and on
+ * other platforms), the file is merely extended. Once the serialization is complete, the file is
+ * truncated to the exact size of the output.
+ *
+ * Failures are reported by throwing a `std::system_error`.
+ *
+ * @note Call `close()` once the serialization is complete. The `file_write_options` are honoured
+ * as they are by the `file_output_stream`, except for the `buffer_size`, which doesn't apply.
+ **/
+class mmap_output_stream
+{
+  public:
+    using Ch = char;
+
+    explicit mmap_output_stream(const std::string& path, const file_write_options& options = {})
+        : m_file{ path, options, /* readable = */ true },
+          m_extent_size{ round_to_page_size(options.mmap_extent_size) },
+          m_sync{ options.sync }
+    {
+        map_next_extent();
+    }
+
+#if __cplusplus >= 201703L // C++17
+    explicit mmap_output_stream(
+        const std::filesystem::path& path, const file_write_options& options = {})
+        : mmap_output_stream{ path.string(), options }
+    {
+    }
+#endif
+
+    mmap_output_stream(const mmap_output_stream&) = delete;
+    mmap_output_stream& operator=(const mmap_output_stream&) = delete;
+
+    ~mmap_output_stream()
+    {
+        const auto size = written_size();
+        unmap(/* wait = */ false);
+
+        // Don't leave the unused tail of the last extent behind in a file that's being kept.
+        if (m_file.is_open() && !m_file.is_atomic()) {
+            static_cast<void>(::ftruncate(m_file.get(), static_cast<off_t>(size)));
+        }
+    }
+
+    void Put(Ch character)
+    {
+        if (m_cursor == m_mapping_end) {
+            map_next_extent();
+        }
+
+        *m_cursor++ = character;
+    }
+
+    /**
+     * The data is already in the page cache, so there's nothing to flush.
+     **/
+    void Flush() noexcept
+    {
+    }
+
+    void write(const Ch* data, std::size_t length)
+    {
+        while (length != 0) {
+            if (m_cursor == m_mapping_end) {
+                map_next_extent();
+            }
+
+            const auto available = static_cast<std::size_t>(m_mapping_end - m_cursor);
+            const auto chunk = std::min(length, available);
+            std::memcpy(m_cursor, data, chunk);
+
+            m_cursor += chunk;
+            data += chunk;
+            length -= chunk;
+        }
+    }
+
+    /**
+     * Unmaps the file, truncates it to the size of the output, syncs and closes it, and, if
+     * requested, renames the temporary file over the target.
+     **/
+    void close()
+    {
+        if (!m_file.is_open()) {
+            return;
+        }
+
+        const auto size = written_size();
+        unmap(/* wait = */ true);
+
+        if (::ftruncate(m_file.get(), static_cast<off_t>(size)) != 0) {
+            m_file.fail("Could not truncate");
+        }
+
+        m_file.commit();
+    }
+
+  private:
+    static std::size_t round_to_page_size(std::size_t size) noexcept
+    {
+        const auto page = detail::page_size();
+        return std::max<std::size_t>((size + page - 1) / page, 1) * page;
+    }
+
+    /**
+     * @note While no extent is mapped, the mapping offset is the size of the output so far.
+     **/
+    std::size_t written_size() const noexcept
+    {
+        return m_mapping_offset + static_cast<std::size_t>(m_cursor - m_mapping);
+    }
+
+    void extend(std::size_t offset)
+    {
+#if defined(__linux__)
+        if (m_can_preallocate) {
+            if (::fallocate(
+                    m_file.get(), 0, static_cast<off_t>(offset),
+                    static_cast<off_t>(m_extent_size)) == 0) {
+                return;
+            }
+
+            if (errno != EOPNOTSUPP && errno != ENOSYS) {
+                m_file.fail("Could not allocate space for");
+            }
+
+            m_can_preallocate = false;
+        }
+#endif
+
+        if (::ftruncate(m_file.get(), static_cast<off_t>(offset + m_extent_size)) != 0) {
+            m_file.fail("Could not extend");
+        }
+    }
+
+    /**
+     * Maps the extent that follows the current one, which must either be full, or not exist.
+     **/
+    void map_next_extent()
+    {
+        unmap(/* wait = */ false);
+
+        const auto offset = m_mapping_offset;
+        extend(offset);
+
+        void* const mapping = ::mmap(
+            nullptr, m_extent_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_file.get(),
+            static_cast<off_t>(offset));
+
+        if (mapping == MAP_FAILED) {
+            m_file.fail("Could not map");
+        }
+
+        ::madvise(mapping, m_extent_size, MADV_SEQUENTIAL);
+
+        m_mapping = static_cast<char*>(mapping);
+        m_mapping_offset = offset;
+        m_cursor = m_mapping;
+        m_mapping_end = m_mapping + m_extent_size;
+    }
+
+    /**
+     * @param wait                  Whether to wait for the extent to be written back, if syncing
+     *                              was requested. Otherwise, writeback is merely initiated, so
+     *                              that it overlaps with the serialization of the next extent.
+     **/
+    void unmap(bool wait) noexcept
+    {
+        if (m_mapping == nullptr) {
+            return;
+        }
+
+        m_mapping_offset = written_size();
+
+        if (m_sync) {
+            ::msync(m_mapping, m_extent_size, wait ? MS_SYNC : MS_ASYNC);
+        }
+
+        ::munmap(m_mapping, m_extent_size);
+
+        m_mapping = nullptr;
+        m_cursor = nullptr;
+        m_mapping_end = nullptr;
+    }
+
+    detail::output_file m_file;
+    std::size_t m_extent_size;
+    bool m_sync;
+    bool m_can_preallocate = true;
+
+    char* m_mapping = nullptr;
+    char* m_cursor = nullptr;
+    char* m_mapping_end = nullptr;
+    std::size_t m_mapping_offset = 0;
+};
+} // namespace json_utils
+
+#endif
@@ -0,0 +1,503 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <rapidjson/rapidjson.h>
+
+#include "json_binary_reader.h"
+
+namespace json_utils
+{
+namespace msgpack
+{
+/**
+ * The MessagePack type markers, as defined by the specification.
+ **/
+enum marker : std::uint8_t
+{
+    positive_fixint_max = 0x7F,
+    fixmap = 0x80,
+    fixarray = 0x90,
+    fixstr = 0xA0,
+    nil = 0xC0,
+    false_value = 0xC2,
+    true_value = 0xC3,
+    float32 = 0xCA,
+    float64 = 0xCB,
+    uint8 = 0xCC,
+    uint16 = 0xCD,
+    uint32 = 0xCE,
+    uint64 = 0xCF,
+    int8 = 0xD0,
+    int16 = 0xD1,
+    int32 = 0xD2,
+    int64 = 0xD3,
+    str8 = 0xD9,
+    str16 = 0xDA,
+    str32 = 0xDB,
+    array16 = 0xDC,
+    array32 = 0xDD,
+    map16 = 0xDE,
+    map32 = 0xDF,
+    negative_fixint_min = 0xE0
+};
+} // namespace msgpack
+
+/**
+ * A writer that implements the same handler interface as `rapidjson::Writer<...>` (`StartObject`,
+ * `Key`, `Int64`, and so on), but that emits MessagePack instead of JSON. Since every
+ * `to_json(...)` overload is written against that interface, any type that can be serialized to
+ * JSON can be serialized to MessagePack as well.
+ *
+ * Integers are written in the smallest representation that holds them, as are string, array, and
+ * map headers. Since the number of elements in a container is only known once it has been closed,
+ * the container's header is inserted in front of its elements at that point.
+ *
+ * @note The writer appends to the buffer passed to its constructor, which must outlive it.
+ **/
+class msgpack_writer
+{
+  public:
+    using Ch = char;
+
+    explicit msgpack_writer(std::vector<std::uint8_t>& output) noexcept : m_output{ &output }
+    {
+    }
+
+    /**
+     * Prepares the writer for another document, which will be appended to the given buffer.
+     **/
+    void Reset(std::vector<std::uint8_t>& output) noexcept
+    {
+        m_output = &output;
+        m_containers.clear();
+        m_has_root = false;
+    }
+
+    bool IsComplete() const noexcept
+    {
+        return m_has_root && m_containers.empty();
+    }
+
+    bool Null()
+    {
+        begin_value();
+        put(msgpack::nil);
+        return true;
+    }
+
+    bool Bool(bool value)
+    {
+        begin_value();
+        put(value ? msgpack::true_value : msgpack::false_value);
+        return true;
+    }
+
+    bool Int(int value)
+    {
+        return Int64(value);
+    }
+
+    bool Uint(unsigned value)
+    {
+        return Uint64(value);
+    }
+
+    bool Int64(std::int64_t value)
+    {
+        begin_value();
+
+        if (value >= 0) {
+            write_unsigned(static_cast<std::uint64_t>(value));
+        } else {
+            write_negative(value);
+        }
+
+        return true;
+    }
+
+    bool Uint64(std::uint64_t value)
+    {
+        begin_value();
+        write_unsigned(value);
+        return true;
+    }
+
+    bool Double(double value)
+    {
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof bits);
+
+        begin_value();
+        put(msgpack::float64);
+        put_big_endian(bits, sizeof bits);
+
+        return true;
+    }
+
+    bool Float(float value)
+    {
+        std::uint32_t bits;
+        std::memcpy(&bits, &value, sizeof bits);
+
+        begin_value();
+        put(msgpack::float32);
+        put_big_endian(bits, sizeof bits);
+
+        return true;
+    }
+
+    bool String(const Ch* data, rapidjson::SizeType length, bool /*copy*/ = false)
+    {
+        begin_value();
+        write_string(data, length);
+        return true;
+    }
+
+    bool String(const Ch* data)
+    {
+        return String(data, static_cast<rapidjson::SizeType>(std::strlen(data)));
+    }
+
+    bool Key(const Ch* data, rapidjson::SizeType length, bool /*copy*/ = false)
+    {
+        ++m_containers.back().count;
+        write_string(data, length);
+        return true;
+    }
+
+    bool Key(const Ch* data)
+    {
+        return Key(data, static_cast<rapidjson::SizeType>(std::strlen(data)));
+    }
+
+    bool StartObject()
+    {
+        begin_value();
+        m_containers.push_back({ m_output->size(), 0, /* is_object = */ true });
+        return true;
+    }
+
+    bool EndObject(rapidjson::SizeType /*member_count*/ = 0)
+    {
+        end_container(msgpack::fixmap, msgpack::map16, msgpack::map32);
+        return true;
+    }
+
+    bool StartArray()
+    {
+        begin_value();
+        m_containers.push_back({ m_output->size(), 0, /* is_object = */ false });
+        return true;
+    }
+
+    bool EndArray(rapidjson::SizeType /*element_count*/ = 0)
+    {
+        end_container(msgpack::fixarray, msgpack::array16, msgpack::array32);
+        return true;
+    }
+
+  private:
+    struct container
+    {
+        std::size_t offset;
+        std::size_t count;
+        bool is_object;
+    };
+
+    void begin_value()
+    {
+        if (m_containers.empty()) {
+            m_has_root = true;
+        } else if (!m_containers.back().is_object) {
+            ++m_containers.back().count;
+        }
+    }
+
+    void put(std::uint8_t byte)
+    {
+        m_output->push_back(byte);
+    }
+
+    static std::uint8_t* store_big_endian(
+        std::uint8_t* destination, std::uint64_t value, std::size_t size) noexcept
+    {
+        for (auto shift = size * 8; shift != 0; shift -= 8) {
+            *destination++ = static_cast<std::uint8_t>(value >> (shift - 8));
+        }
+
+        return destination;
+    }
+
+    void put_big_endian(std::uint64_t value, std::size_t size)
+    {
+        std::uint8_t bytes[8];
+        m_output->insert(m_output->end(), bytes, store_big_endian(bytes, value, size));
+    }
+
+    void write_unsigned(std::uint64_t value)
+    {
+        if (value <= msgpack::positive_fixint_max) {
+            put(static_cast<std::uint8_t>(value));
+        } else if (value <= UINT8_MAX) {
+            put(msgpack::uint8);
+            put_big_endian(value, 1);
+        } else if (value <= UINT16_MAX) {
+            put(msgpack::uint16);
+            put_big_endian(value, 2);
+        } else if (value <= UINT32_MAX) {
+            put(msgpack::uint32);
+            put_big_endian(value, 4);
+        } else {
+            put(msgpack::uint64);
+            put_big_endian(value, 8);
+        }
+    }
+
+    void write_negative(std::int64_t value)
+    {
+        const auto bits = static_cast<std::uint64_t>(value);
+
+        if (value >= -32) {
+            put(static_cast<std::uint8_t>(bits));
+        } else if (value >= INT8_MIN) {
+            put(msgpack::int8);
+            put_big_endian(bits, 1);
+        } else if (value >= INT16_MIN) {
+            put(msgpack::int16);
+            put_big_endian(bits, 2);
+        } else if (value >= INT32_MIN) {
+            put(msgpack::int32);
+            put_big_endian(bits, 4);
+        } else {
+            put(msgpack::int64);
+            put_big_endian(bits, 8);
+        }
+    }
+
+    void write_string(const Ch* data, rapidjson::SizeType length)
+    {
+        if (length < 32) {
+            put(static_cast<std::uint8_t>(msgpack::fixstr | length));
+        } else if (length <= UINT8_MAX) {
+            put(msgpack::str8);
+            put_big_endian(length, 1);
+        } else if (length <= UINT16_MAX) {
+            put(msgpack::str16);
+            put_big_endian(length, 2);
+        } else {
+            put(msgpack::str32);
+            put_big_endian(length, 4);
+        }
+
+        const auto* const bytes = reinterpret_cast<const std::uint8_t*>(data);
+        m_output->insert(m_output->end(), bytes, bytes + length);
+    }
+
+    /**
+     * Inserts the header of the container that's being closed in front of its elements.
+     **/
+    void end_container(std::uint8_t fix_marker, std::uint8_t marker16, std::uint8_t marker32)
+    {
+        const auto closed = m_containers.back();
+        m_containers.pop_back();
+
+        std::uint8_t header[5];
+        auto* header_end = header;
+
+        if (closed.count < 16) {
+            *header_end++ = static_cast<std::uint8_t>(fix_marker | closed.count);
+        } else if (closed.count <= UINT16_MAX) {
+            *header_end++ = marker16;
+            header_end = store_big_endian(header_end, closed.count, 2);
+        } else {
+            *header_end++ = marker32;
+            header_end = store_big_endian(header_end, closed.count, 4);
+        }
+
+        const auto position = m_output->begin() + static_cast<std::ptrdiff_t>(closed.offset);
+        m_output->insert(position, header, header_end);
+    }
+
+    std::vector<std::uint8_t>* m_output;
+    std::vector<container> m_containers;
+    bool m_has_root = false;
+};
+
+namespace detail
+{
+struct msgpack_decoder
+{
+    template <typename HandlerType>
+    static void read_key(binary_input& input, HandlerType& handler)
+    {
+        const auto marker = input.read_byte();
+        const auto length = read_string_length(input, marker);
+
+        const auto* const key = input.read_bytes(length);
+        check_handler_result(
+            input, handler.Key(key, static_cast<rapidjson::SizeType>(length), true));
+    }
+
+    static std::uint64_t read_string_length(binary_input& input, std::uint8_t marker)
+    {
+        if ((marker & 0xE0) == msgpack::fixstr) {
+            return marker & 0x1F;
+        }
+
+        switch (marker) {
+            case msgpack::str8:
+                return input.read_big_endian(1);
+            case msgpack::str16:
+                return input.read_big_endian(2);
+            case msgpack::str32:
+                return input.read_big_endian(4);
+            default:
+                input.fail("Map keys must be strings");
+        }
+    }
+
+    static std::int64_t sign_extend(std::uint64_t value, std::size_t size) noexcept
+    {
+        const auto shift = 64 - size * 8;
+        return static_cast<std::int64_t>(value << shift) >> shift;
+    }
+
+    template <typename HandlerType>
+    static void
+    read_value(binary_input& input, binary_container_stack& containers, HandlerType& handler)
+    {
+        const auto marker = input.read_byte();
+
+        if (marker <= msgpack::positive_fixint_max) {
+            check_handler_result(input, report_unsigned(handler, marker));
+        } else if (marker >= msgpack::negative_fixint_min) {
+            check_handler_result(input, report_signed(handler, sign_extend(marker, 1)));
+        } else if ((marker & 0xF0) == msgpack::fixmap || (marker & 0xF0) == msgpack::fixarray) {
+            open_container(input, containers, handler, marker & 0x0F, marker < msgpack::fixarray);
+            return;
+        } else if ((marker & 0xE0) == msgpack::fixstr) {
+            read_string(input, handler, marker);
+        } else {
+            switch (marker) {
+                case msgpack::nil:
+                    check_handler_result(input, handler.Null());
+                    break;
+                case msgpack::false_value:
+                case msgpack::true_value:
+                    check_handler_result(input, handler.Bool(marker == msgpack::true_value));
+                    break;
+                case msgpack::float32:
+                    check_handler_result(input, handler.Double(read_float(input)));
+                    break;
+                case msgpack::float64:
+                    check_handler_result(input, handler.Double(read_double(input)));
+                    break;
+                case msgpack::uint8:
+                case msgpack::uint16:
+                case msgpack::uint32:
+                case msgpack::uint64: {
+                    const auto size = std::size_t{ 1 } << (marker - msgpack::uint8);
+                    const auto value = input.read_big_endian(size);
+                    check_handler_result(input, report_unsigned(handler, value));
+                    break;
+                }
+                case msgpack::int8:
+                case msgpack::int16:
+                case msgpack::int32:
+                case msgpack::int64: {
+                    const auto size = std::size_t{ 1 } << (marker - msgpack::int8);
+                    const auto value = sign_extend(input.read_big_endian(size), size);
+                    check_handler_result(input, report_signed(handler, value));
+                    break;
+                }
+                case msgpack::str8:
+                case msgpack::str16:
+                case msgpack::str32:
+                    read_string(input, handler, marker);
+                    break;
+                case msgpack::array16:
+                case msgpack::map16:
+                    open_container(
+                        input, containers, handler, input.read_big_endian(2),
+                        marker == msgpack::map16);
+                    return;
+                case msgpack::array32:
+                case msgpack::map32:
+                    open_container(
+                        input, containers, handler, input.read_big_endian(4),
+                        marker == msgpack::map32);
+                    return;
+                default:
+                    input.fail("Unsupported MessagePack type");
+            }
+        }
+
+        containers.complete_value();
+    }
+
+    template <typename HandlerType>
+    static void read_string(binary_input& input, HandlerType& handler, std::uint8_t marker)
+    {
+        const auto length = read_string_length(input, marker);
+        const auto* const data = input.read_bytes(length);
+
+        check_handler_result(
+            input, handler.String(data, static_cast<rapidjson::SizeType>(length), true));
+    }
+
+    static double read_float(binary_input& input)
+    {
+        const auto bits = static_cast<std::uint32_t>(input.read_big_endian(4));
+
+        float value;
+        std::memcpy(&value, &bits, sizeof value);
+
+        return value;
+    }
+
+    static double read_double(binary_input& input)
+    {
+        const auto bits = input.read_big_endian(8);
+
+        double value;
+        std::memcpy(&value, &bits, sizeof value);
+
+        return value;
+    }
+
+    template <typename HandlerType>
+    static void open_container(
+        binary_input& input, binary_container_stack& containers, HandlerType& handler,
+        std::uint64_t element_count, bool is_object)
+    {
+        check_handler_result(input, is_object ? handler.StartObject() : handler.StartArray());
+        containers.push(element_count, is_object);
+    }
+};
+} // namespace detail
+
+/**
+ * Decodes a MessagePack document, and reports its contents to a handler as the same sequence of
+ * events that `rapidjson::Reader` produces for the equivalent JSON text. Any rapidjson SAX handler
+ * can therefore consume MessagePack, including the handler that backs `deserialize_via_sax(...)`.
+ *
+ * Numbers are reported without any text parsing, and strings are reported in place, without any
+ * unescaping or copying. Binary data, extension types, and maps with non-string keys have no JSON
+ * equivalent, and are rejected.
+ *
+ * Malformed input, and handlers that return false, cause a `std::runtime_error` to be thrown.
+ **/
+class msgpack_reader
+{
+  public:
+    template <typename HandlerType>
+    void parse(const std::uint8_t* data, std::size_t size, HandlerType& handler) const
+    {
+        detail::decode_binary_document<detail::msgpack_decoder>(data, size, handler);
+    }
+};
+} // namespace json_utils
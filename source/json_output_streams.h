@@ -0,0 +1,963 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#if __cplusplus >= 201703L // C++17
+#include <filesystem>
+#endif
+
+// clang-format off
+#if defined(__unix__) || defined(__APPLE__)
+    #define JSON_UTILS_POSIX_FILES
+    #include <fcntl.h>
+    #include <sys/stat.h>
+    #include <sys/uio.h>
+    #include <unistd.h>
+#elif defined(_WIN32)
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#endif
+// clang-format on
+
+#include <rapidjson/rapidjson.h>
+
+namespace json_utils
+{
+/**
+ * An output stream that satisfies rapidjson's `Stream` concept and writes directly into a
+ * `std::basic_string<...>`. Once serialization is complete, the string can be moved out of the
+ * stream, avoiding the copy (and `strlen`) that `rapidjson::GenericStringBuffer<...>` requires.
+ **/
+template <typename EncodingType = rapidjson::UTF8<>> class string_output_stream
+{
+  public:
+    using Ch = typename EncodingType::Ch;
+    using string_type = std::basic_string<Ch>;
+
+    string_output_stream() = default;
+
+    explicit string_output_stream(std::size_t capacity)
+    {
+        m_string.reserve(capacity);
+    }
+
+    void Put(Ch character)
+    {
+        m_string.push_back(character);
+    }
+
+    void Flush() noexcept
+    {
+    }
+
+    void write(const Ch* data, std::size_t length)
+    {
+        m_string.append(data, length);
+    }
+
+    void reserve(std::size_t capacity)
+    {
+        m_string.reserve(capacity);
+    }
+
+    /**
+     * Appends a copy of characters that were previously written to the stream.
+     **/
+    void repeat(std::size_t offset, std::size_t length)
+    {
+        // Appending from the string itself could otherwise reallocate it while it is being read.
+        m_string.reserve(m_string.size() + length);
+        m_string.append(m_string, offset, length);
+    }
+
+    /**
+     * Discards the contents of the stream, while retaining its capacity.
+     **/
+    void clear() noexcept
+    {
+        m_string.clear();
+    }
+
+    std::size_t size() const noexcept
+    {
+        return m_string.size();
+    }
+
+    const string_type& str() const noexcept
+    {
+        return m_string;
+    }
+
+    /**
+     * @returns The serialized string. The stream is left empty, but remains usable.
+     **/
+    string_type release() noexcept
+    {
+        string_type result = std::move(m_string);
+        m_string.clear();
+
+        return result;
+    }
+
+  private:
+    string_type m_string;
+};
+
+/**
+ * An output stream that discards its input and only counts the number of characters written to it.
+ * This makes it possible to determine the exact size of a serialization before allocating any
+ * storage for it.
+ **/
+template <typename EncodingType = rapidjson::UTF8<>> class counting_output_stream
+{
+  public:
+    using Ch = typename EncodingType::Ch;
+
+    void Put(Ch /*character*/) noexcept
+    {
+        ++m_count;
+    }
+
+    void Flush() noexcept
+    {
+    }
+
+    void write(const Ch* /*data*/, std::size_t length) noexcept
+    {
+        m_count += length;
+    }
+
+    std::size_t size() const noexcept
+    {
+        return m_count;
+    }
+
+  private:
+    std::size_t m_count = 0;
+};
+
+/**
+ * An output stream that collects the output into fixed-size chunks, handing each chunk to a
+ * callback with the signature `void(const Ch* data, std::size_t size)` as soon as it fills up. The
+ * final, partial chunk is handed over when rapidjson flushes the stream at the end of the document
+ * (or when `Flush()` is called explicitly).
+ *
+ * This makes it possible to start sending a document (e.g., over a socket) before it has been
+ * serialized in its entirety, while bounding the memory used to the size of a single chunk.
+ *
+ * @note Any exception thrown by the callback propagates out of the writer.
+ **/
+template <typename CallbackType, typename EncodingType = rapidjson::UTF8<>>
+class chunked_output_stream
+{
+  public:
+    using Ch = typename EncodingType::Ch;
+
+    static constexpr std::size_t default_chunk_size = 64 * 1024;
+
+    explicit chunked_output_stream(
+        CallbackType callback, std::size_t chunk_size = default_chunk_size)
+        : m_callback(std::forward<CallbackType>(callback)),
+          m_chunk(std::max<std::size_t>(chunk_size, 1))
+    {
+    }
+
+    void Put(Ch character)
+    {
+        m_chunk[m_size++] = character;
+
+        if (m_size == m_chunk.size()) {
+            emit();
+        }
+    }
+
+    void Flush()
+    {
+        if (m_size != 0) {
+            emit();
+        }
+    }
+
+    void write(const Ch* data, std::size_t length)
+    {
+        while (length != 0) {
+            const auto count = std::min(length, m_chunk.size() - m_size);
+            std::copy(data, data + count, m_chunk.data() + m_size);
+
+            m_size += count;
+            data += count;
+            length -= count;
+
+            if (m_size == m_chunk.size()) {
+                emit();
+            }
+        }
+    }
+
+  private:
+    void emit()
+    {
+        // Reset the chunk first, so that it's left in a consistent state if the callback throws.
+        const auto size = m_size;
+        m_size = 0;
+
+        m_callback(static_cast<const Ch*>(m_chunk.data()), size);
+    }
+
+    CallbackType m_callback;
+    std::vector<Ch> m_chunk;
+    std::size_t m_size = 0;
+};
+
+/**
+ * A contiguous piece of the output produced by a `segment_output_stream`.
+ **/
+struct output_segment
+{
+    const char* data;
+    std::size_t size;
+};
+
+/**
+ * An output stream that produces its output as a list of segments, suitable for scatter-gather I/O
+ * (e.g., `writev(...)` or `sendmsg(...)`). Structural characters, short strings, and escape
+ * sequences are collected in a scratch buffer, while long runs of characters that don't require
+ * escaping are referenced directly from the strings that they came from, and are never copied.
+ *
+ * Only strings that are wrapped in a `stable_string` are referenced. Everything else, including
+ * `std::string` values (which may well be temporaries created during serialization), is copied.
+ *
+ * @note The segments refer both to the stream's scratch buffer and to the strings wrapped in a
+ * `stable_string`, so the stream and those strings must outlive any use of the segments, and the
+ * strings mustn't be modified in the meantime.
+ **/
+class segment_output_stream
+{
+  public:
+    using Ch = char;
+
+    static constexpr std::size_t default_minimum_reference_size = 1024;
+
+    /**
+     * @param minimum_reference_size   Runs of characters shorter than this are copied into the
+     *                                 scratch buffer, since referencing them would cost more than
+     *                                 copying them.
+     **/
+    explicit segment_output_stream(
+        std::size_t minimum_reference_size = default_minimum_reference_size)
+        : m_minimum_reference_size{ std::max<std::size_t>(minimum_reference_size, 1) }
+    {
+    }
+
+    void Put(Ch character)
+    {
+        m_scratch.push_back(character);
+    }
+
+    void Flush() noexcept
+    {
+    }
+
+    void write(const Ch* data, std::size_t length)
+    {
+        m_scratch.append(data, length);
+    }
+
+    /**
+     * Appends a segment that refers to the given data, rather than copying it.
+     **/
+    void refer(const Ch* data, std::size_t length)
+    {
+        close_scratch_run();
+        m_entries.push_back({ data, 0, length });
+    }
+
+    std::size_t minimum_reference_size() const noexcept
+    {
+        return m_minimum_reference_size;
+    }
+
+    /**
+     * @returns The output, in order, as a list of segments. The segments that point into the
+     * scratch buffer are invalidated by any further writes to the stream.
+     **/
+    std::vector<output_segment> segments() const
+    {
+        std::vector<output_segment> result;
+        result.reserve(m_entries.size() + 1);
+
+        for (const auto& entry : m_entries) {
+            result.push_back(resolve(entry));
+        }
+
+        if (m_run_start != m_scratch.size()) {
+            result.push_back({ m_scratch.data() + m_run_start, m_scratch.size() - m_run_start });
+        }
+
+        return result;
+    }
+
+#ifdef JSON_UTILS_POSIX_FILES
+    /**
+     * @returns The segments as I/O vectors, ready to be passed to `writev(...)` or `sendmsg(...)`.
+     *
+     * @note A single system call accepts at most `IOV_MAX` vectors, so longer lists have to be
+     * submitted in several batches.
+     **/
+    std::vector<iovec> to_iovecs() const
+    {
+        const auto parts = segments();
+
+        std::vector<iovec> result;
+        result.reserve(parts.size());
+
+        for (const auto& part : parts) {
+            result.push_back({ const_cast<char*>(part.data), part.size });
+        }
+
+        return result;
+    }
+#endif
+
+    /**
+     * @returns The total size of the output, including the referenced data.
+     **/
+    std::size_t size() const noexcept
+    {
+        std::size_t total = m_scratch.size();
+
+        for (const auto& entry : m_entries) {
+            if (entry.external != nullptr) {
+                total += entry.size;
+            }
+        }
+
+        return total;
+    }
+
+    /**
+     * @returns The output, concatenated into a single string.
+     **/
+    std::string str() const
+    {
+        std::string result;
+        result.reserve(size());
+
+        for (const auto& part : segments()) {
+            result.append(part.data, part.size);
+        }
+
+        return result;
+    }
+
+    /**
+     * Discards the contents of the stream, while retaining the capacity of the scratch buffer.
+     **/
+    void clear() noexcept
+    {
+        m_scratch.clear();
+        m_entries.clear();
+        m_run_start = 0;
+    }
+
+  private:
+    /**
+     * Segments in the scratch buffer are recorded by offset, since the buffer may be reallocated.
+     **/
+    struct entry
+    {
+        const Ch* external;
+        std::size_t offset;
+        std::size_t size;
+    };
+
+    void close_scratch_run()
+    {
+        if (m_run_start == m_scratch.size()) {
+            return;
+        }
+
+        m_entries.push_back({ nullptr, m_run_start, m_scratch.size() - m_run_start });
+        m_run_start = m_scratch.size();
+    }
+
+    output_segment resolve(const entry& entry) const noexcept
+    {
+        if (entry.external != nullptr) {
+            return { entry.external, entry.size };
+        }
+
+        return { m_scratch.data() + entry.offset, entry.size };
+    }
+
+    std::string m_scratch;
+    std::vector<entry> m_entries;
+    std::size_t m_run_start = 0;
+    std::size_t m_minimum_reference_size;
+};
+
+struct file_write_options
+{
+    /**
+     * The size of the user-space buffer. Data is handed to the operating system in blocks of this
+     * size.
+     **/
+    std::size_t buffer_size = std::size_t{ 1 } << 20;
+
+    /**
+     * Forces the file's contents out to the storage device (via `fdatasync(...)`) before the file
+     * is closed.
+     **/
+    bool sync = false;
+
+    /**
+     * Writes to a temporary file in the same directory, which is then renamed over the target path
+     * once the write has completed, so that readers never observe a partially written file. When
+     * combined with `sync`, the directory is synced as well, so that the rename itself is durable.
+     *
+     * @note The replacement is atomic on POSIX systems and on Windows. Elsewhere, the target has to
+     * be removed before the temporary file can be renamed.
+     **/
+    bool atomic_replace = false;
+
+    /**
+     * When writing through a memory mapping, the file is grown, and mapped, in extents of this
+     * size (rounded up to a multiple of the page size).
+     **/
+    std::size_t mmap_extent_size = std::size_t{ 64 } << 20;
+};
+
+namespace detail
+{
+[[noreturn]] inline void throw_system_error(int error, const std::string& what)
+{
+    throw std::system_error{ error, std::generic_category(), what };
+}
+
+#ifdef JSON_UTILS_POSIX_FILES
+
+using native_file = int;
+
+constexpr native_file invalid_file = -1;
+
+inline native_file
+open_for_writing(const std::string& path, bool exclusive, bool readable = false) noexcept
+{
+    const auto flags = (readable ? O_RDWR : O_WRONLY) | O_CREAT | O_CLOEXEC |
+                       (exclusive ? O_EXCL : O_TRUNC);
+
+    native_file file;
+    do {
+        file = ::open(path.c_str(), flags, 0666);
+    } while (file == invalid_file && errno == EINTR);
+
+    return file;
+}
+
+inline bool write_fully(native_file file, const char* data, std::size_t size) noexcept
+{
+    while (size != 0) {
+        const auto written = ::write(file, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            return false;
+        }
+
+        data += written;
+        size -= static_cast<std::size_t>(written);
+    }
+
+    return true;
+}
+
+inline bool sync_file(native_file file) noexcept
+{
+#if defined(__APPLE__)
+    return ::fsync(file) == 0;
+#else
+    return ::fdatasync(file) == 0;
+#endif
+}
+
+inline bool close_file(native_file file) noexcept
+{
+    // Retrying `close(...)` after `EINTR` isn't safe, since the descriptor may already be released.
+    return ::close(file) == 0;
+}
+
+inline bool sync_parent_directory(const std::string& path) noexcept
+{
+    const auto separator = path.find_last_of('/');
+    const auto directory = separator == std::string::npos
+                               ? std::string{ "." }
+                               : path.substr(0, separator == 0 ? 1 : separator);
+
+    const auto file = ::open(directory.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file == invalid_file) {
+        return false;
+    }
+
+    const auto synced = ::fsync(file) == 0;
+    ::close(file);
+
+    return synced;
+}
+
+inline bool replace_file(const std::string& source, const std::string& target) noexcept
+{
+    // POSIX guarantees that `rename(...)` atomically replaces the target.
+    return std::rename(source.c_str(), target.c_str()) == 0;
+}
+
+inline void remove_file(const std::string& path) noexcept
+{
+    ::unlink(path.c_str());
+}
+
+inline char* allocate_file_buffer(std::size_t size)
+{
+    void* buffer = nullptr;
+    if (::posix_memalign(&buffer, 4096, size) != 0) {
+        throw std::bad_alloc{};
+    }
+
+    return static_cast<char*>(buffer);
+}
+
+#else
+
+using native_file = std::FILE*;
+
+constexpr native_file invalid_file = nullptr;
+
+#ifdef _WIN32
+
+/**
+ * Paths are passed around as UTF-8 (see `path_to_string(...)`), and widened for the Windows API, so
+ * that paths that can't be represented in the active code page can still be opened.
+ **/
+inline std::wstring widen_path(const std::string& path)
+{
+    const auto size = static_cast<int>(path.size());
+    const auto length = ::MultiByteToWideChar(CP_UTF8, 0, path.data(), size, nullptr, 0);
+
+    std::wstring result(static_cast<std::size_t>(length), L'\0');
+    ::MultiByteToWideChar(CP_UTF8, 0, path.data(), size, &result[0], length);
+
+    return result;
+}
+
+inline native_file open_for_writing(
+    const std::string& path, bool /*exclusive*/, bool /*readable*/ = false) noexcept
+{
+    try {
+        return ::_wfopen(widen_path(path).c_str(), L"wb");
+    } catch (...) {
+        errno = ENOMEM;
+        return invalid_file;
+    }
+}
+
+#else
+
+inline native_file open_for_writing(
+    const std::string& path, bool /*exclusive*/, bool /*readable*/ = false) noexcept
+{
+    return std::fopen(path.c_str(), "wb");
+}
+
+#endif
+
+inline bool write_fully(native_file file, const char* data, std::size_t size) noexcept
+{
+    return std::fwrite(data, 1, size, file) == size;
+}
+
+inline bool sync_file(native_file file) noexcept
+{
+    return std::fflush(file) == 0;
+}
+
+inline bool close_file(native_file file) noexcept
+{
+    return std::fclose(file) == 0;
+}
+
+inline bool sync_parent_directory(const std::string& /*path*/) noexcept
+{
+    return true;
+}
+
+#ifdef _WIN32
+
+inline bool replace_file(const std::string& source, const std::string& target) noexcept
+{
+    try {
+        const auto flags = MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH;
+        if (::MoveFileExW(widen_path(source).c_str(), widen_path(target).c_str(), flags)) {
+            return true;
+        }
+    } catch (...) {
+        errno = ENOMEM;
+        return false;
+    }
+
+    // Errors are reported through `errno`, like those of the other functions here.
+    switch (::GetLastError()) {
+        case ERROR_FILE_NOT_FOUND:
+        case ERROR_PATH_NOT_FOUND:
+            errno = ENOENT;
+            break;
+        case ERROR_ACCESS_DENIED:
+        case ERROR_SHARING_VIOLATION:
+            errno = EACCES;
+            break;
+        default:
+            errno = EIO;
+            break;
+    }
+
+    return false;
+}
+
+inline void remove_file(const std::string& path) noexcept
+{
+    try {
+        ::_wremove(widen_path(path).c_str());
+    } catch (...) {
+    }
+}
+
+#else
+
+/**
+ * @note Without POSIX or Windows semantics, `rename(...)` may refuse to overwrite an existing file,
+ * so the target is removed first, and the replacement isn't atomic.
+ **/
+inline bool replace_file(const std::string& source, const std::string& target) noexcept
+{
+    std::remove(target.c_str());
+    return std::rename(source.c_str(), target.c_str()) == 0;
+}
+
+inline void remove_file(const std::string& path) noexcept
+{
+    std::remove(path.c_str());
+}
+
+#endif
+
+inline char* allocate_file_buffer(std::size_t size)
+{
+    return static_cast<char*>(::operator new(size));
+}
+
+#endif
+
+struct file_buffer_deleter
+{
+    void operator()(char* buffer) const noexcept
+    {
+#ifdef JSON_UTILS_POSIX_FILES
+        std::free(buffer);
+#else
+        ::operator delete(buffer);
+#endif
+    }
+};
+
+#if __cplusplus >= 201703L // C++17
+/**
+ * @returns The path as expected by the functions above: in the native narrow encoding on POSIX
+ * systems, and in UTF-8 on Windows, where it is widened again before use.
+ **/
+inline std::string path_to_string(const std::filesystem::path& path)
+{
+#ifdef _WIN32
+    const auto text = path.u8string();
+    return std::string{ text.begin(), text.end() };
+#else
+    return path.string();
+#endif
+}
+#endif
+
+inline std::string make_temporary_path(const std::string& path)
+{
+    static std::atomic<unsigned long> counter{ 0 };
+
+    const auto ticks = std::chrono::steady_clock::now().time_since_epoch().count();
+
+    return path + ".tmp." + std::to_string(ticks) + "." + std::to_string(counter++);
+}
+
+/**
+ * Owns a file that is open for writing, and implements the sync and atomic replacement policies of
+ * the `file_write_options`. Failures are reported by throwing a `std::system_error`.
+ *
+ * @note If the file is destroyed without having been committed, it is simply closed, unless it is a
+ * temporary file destined to replace the target, in which case it is removed.
+ **/
+class output_file
+{
+  public:
+    /**
+     * @param readable              Opens the file for reading as well, as is required in order to
+     *                              map it into memory.
+     **/
+    output_file(const std::string& path, const file_write_options& options, bool readable = false)
+        : m_path{ path }, m_options{ options }
+    {
+        if (!m_options.atomic_replace) {
+            m_file = open_for_writing(m_path, /* exclusive = */ false, readable);
+            if (m_file == invalid_file) {
+                fail("Could not open");
+            }
+
+            return;
+        }
+
+        // Temporary names are unique in practice; the retry merely guards against a stale file.
+        for (int attempt = 0; attempt < 16 && m_file == invalid_file; ++attempt) {
+            m_temporary_path = make_temporary_path(m_path);
+            m_file = open_for_writing(m_temporary_path, /* exclusive = */ true, readable);
+
+            if (m_file == invalid_file && errno != EEXIST) {
+                break;
+            }
+        }
+
+        if (m_file == invalid_file) {
+            const auto error = errno;
+            throw_system_error(error, "Could not create \"" + m_temporary_path + '"');
+        }
+    }
+
+    output_file(const output_file&) = delete;
+    output_file& operator=(const output_file&) = delete;
+
+    ~output_file()
+    {
+        if (m_file == invalid_file) {
+            return;
+        }
+
+        close_file(m_file);
+        discard_temporary_file();
+    }
+
+    native_file get() const noexcept
+    {
+        return m_file;
+    }
+
+    bool is_open() const noexcept
+    {
+        return m_file != invalid_file;
+    }
+
+    bool is_atomic() const noexcept
+    {
+        return m_options.atomic_replace;
+    }
+
+    void write(const char* data, std::size_t length)
+    {
+        if (length != 0 && !write_fully(m_file, data, length)) {
+            fail("Could not write to");
+        }
+    }
+
+    /**
+     * Syncs (if requested) and closes the file, and then renames the temporary file (if any) over
+     * the target.
+     **/
+    void commit()
+    {
+        if (m_file == invalid_file) {
+            return;
+        }
+
+        if (m_options.sync && !sync_file(m_file)) {
+            fail("Could not sync");
+        }
+
+        const auto file = m_file;
+        m_file = invalid_file;
+
+        if (!close_file(file)) {
+            const auto error = errno;
+            discard_temporary_file();
+            throw_system_error(error, "Could not close \"" + m_path + '"');
+        }
+
+        if (!m_options.atomic_replace) {
+            return;
+        }
+
+        if (!replace_file(m_temporary_path, m_path)) {
+            const auto error = errno;
+            discard_temporary_file();
+            throw_system_error(error, "Could not replace \"" + m_path + '"');
+        }
+
+        if (m_options.sync && !sync_parent_directory(m_path)) {
+            fail("Could not sync the directory of");
+        }
+    }
+
+    [[noreturn]] void fail(const char* action) const
+    {
+        const auto error = errno;
+        throw_system_error(error, std::string{ action } + " \"" + m_path + '"');
+    }
+
+  private:
+    void discard_temporary_file() noexcept
+    {
+        if (m_options.atomic_replace) {
+            remove_file(m_temporary_path);
+        }
+    }
+
+    std::string m_path;
+    std::string m_temporary_path;
+    file_write_options m_options;
+    native_file m_file = invalid_file;
+};
+} // namespace detail
+
+/**
+ * An output stream that satisfies rapidjson's `Stream` concept and writes to a file through a
+ * large, page-aligned buffer. Full buffers are handed to the operating system with plain `write(2)`
+ * calls, sidestepping the per-character overhead of `std::ofstream` and
+ * `rapidjson::OStreamWrapper`.
+ *
+ * Failures are reported by throwing a `std::system_error`.
+ *
+ * @note Call `close()` once the serialization is complete; otherwise, errors that occur while
+ * flushing the final block can't be reported. When atomic replacement is requested, the target
+ * file is left untouched unless `close()` succeeds.
+ **/
+class file_output_stream
+{
+  public:
+    using Ch = char;
+
+    explicit file_output_stream(const std::string& path, const file_write_options& options = {})
+        : m_file{ path, options },
+          m_buffer{ detail::allocate_file_buffer(std::max<std::size_t>(options.buffer_size, 1)) },
+          m_cursor{ m_buffer.get() },
+          m_buffer_end{ m_buffer.get() + std::max<std::size_t>(options.buffer_size, 1) }
+    {
+    }
+
+#if __cplusplus >= 201703L // C++17
+    explicit file_output_stream(
+        const std::filesystem::path& path, const file_write_options& options = {})
+        : file_output_stream{ detail::path_to_string(path), options }
+    {
+    }
+#endif
+
+    file_output_stream(const file_output_stream&) = delete;
+    file_output_stream& operator=(const file_output_stream&) = delete;
+
+    ~file_output_stream()
+    {
+        // An abandoned temporary file is discarded anyway, so there's no point in writing it out.
+        if (m_file.is_open() && !m_file.is_atomic()) {
+            detail::write_fully(m_file.get(), m_buffer.get(), buffered_size());
+        }
+    }
+
+    void Put(Ch character)
+    {
+        if (m_cursor == m_buffer_end) {
+            drain();
+        }
+
+        *m_cursor++ = character;
+    }
+
+    /**
+     * Hands any buffered data to the operating system. This doesn't force the data out to the
+     * storage device; see `file_write_options::sync` for that.
+     **/
+    void Flush()
+    {
+        drain();
+    }
+
+    void write(const Ch* data, std::size_t length)
+    {
+        if (length <= static_cast<std::size_t>(m_buffer_end - m_cursor)) {
+            std::memcpy(m_cursor, data, length);
+            m_cursor += length;
+            return;
+        }
+
+        drain();
+
+        if (length >= static_cast<std::size_t>(m_buffer_end - m_buffer.get())) {
+            m_file.write(data, length);
+            return;
+        }
+
+        std::memcpy(m_cursor, data, length);
+        m_cursor += length;
+    }
+
+    /**
+     * Writes out any buffered data, syncs and closes the file, and, if requested, renames the
+     * temporary file over the target.
+     **/
+    void close()
+    {
+        if (!m_file.is_open()) {
+            return;
+        }
+
+        drain();
+        m_file.commit();
+    }
+
+  private:
+    std::size_t buffered_size() const noexcept
+    {
+        return static_cast<std::size_t>(m_cursor - m_buffer.get());
+    }
+
+    void drain()
+    {
+        // Empty the buffer first, so that a failed write isn't retried by the destructor.
+        const auto size = buffered_size();
+        m_cursor = m_buffer.get();
+
+        m_file.write(m_buffer.get(), size);
+    }
+
+    detail::output_file m_file;
+    std::unique_ptr<char, detail::file_buffer_deleter> m_buffer;
+    char* m_cursor;
+    char* m_buffer_end;
+};
+} // namespace json_utils
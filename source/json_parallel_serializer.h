@@ -0,0 +1,255 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "json_output_streams.h"
+#include "json_serialization_options.h"
+#include "json_serializer.h"
+#include "json_writer.h"
+
+namespace json_utils
+{
+namespace detail
+{
+/**
+ * Containers with fewer elements per chunk than this aren't worth splitting up.
+ **/
+constexpr std::size_t minimum_parallel_chunk_size = 256;
+
+/**
+ * Splitting the work into more chunks than there are threads allows threads that finish early to
+ * pick up the slack of those that were handed more expensive elements.
+ **/
+constexpr std::size_t chunks_per_thread = 4;
+
+template <typename WriterType, typename ContainerType>
+void write_elements(WriterType& writer, const ContainerType& container)
+{
+    serializer::to_json(writer, container);
+}
+
+template <typename WriterType, typename IteratorType>
+void write_elements(WriterType& writer, IteratorType begin, IteratorType end, bool is_object)
+{
+    is_object ? writer.StartObject() : writer.StartArray();
+
+    for (; begin != end; ++begin) {
+        serializer::to_json(writer, *begin);
+    }
+
+    is_object ? writer.EndObject() : writer.EndArray();
+}
+
+/**
+ * @returns The number of trailing characters that close a container serialized by the given
+ * writer: the closing bracket, and, in the case of pretty output, the line break preceding it.
+ **/
+template <typename WriterType> constexpr std::size_t closing_length() noexcept
+{
+    return writer_traits<WriterType>::is_pretty ? 2 : 1;
+}
+
+/**
+ * Splits the container into contiguous chunks, serializes each chunk as though it were a complete
+ * container of its own, and then splices the results together, minus their enclosing brackets.
+ *
+ * Chunks are claimed from a shared counter, so a thread that finishes its chunk early simply moves
+ * on to the next unclaimed chunk. Chunk boundaries are located with `std::advance(...)`, which is
+ * constant-time for random-access containers, and a single linear walk for node-based containers.
+ **/
+template <
+    template <typename, typename, typename, typename, unsigned> class WriterTemplate,
+    typename InputEncodingType, typename OutputEncodingType, typename ContainerType>
+std::basic_string<typename OutputEncodingType::Ch> serialize_in_parallel(
+    const ContainerType& container, std::size_t thread_count, const serialization_options& options)
+{
+    constexpr bool is_object = traits::treat_as_object_sink_v<ContainerType>;
+
+    static_assert(
+        is_object || traits::treat_as_array_sink_v<ContainerType>,
+        "Only containers that serialize to a JSON array or object can be split up.");
+
+    using stream_type = string_output_stream<OutputEncodingType>;
+    using writer_type = WriterTemplate<
+        stream_type, InputEncodingType, OutputEncodingType, rapidjson::CrtAllocator,
+        rapidjson::kWriteDefaultFlags>;
+    using iterator_type = decltype(std::begin(container));
+
+    if (thread_count == 0) {
+        thread_count = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+    }
+
+    const auto element_count =
+        static_cast<std::size_t>(std::distance(std::begin(container), std::end(container)));
+
+    const auto chunk_count = std::min(
+        element_count / minimum_parallel_chunk_size, thread_count * chunks_per_thread);
+
+    if (thread_count == 1 || chunk_count <= 1) {
+        stream_type stream;
+        writer_type writer{ stream };
+        writer.set_options(options);
+
+        write_elements(writer, container);
+
+        return stream.release();
+    }
+
+    std::vector<iterator_type> boundaries;
+    boundaries.reserve(chunk_count + 1);
+
+    auto iterator = std::begin(container);
+    for (std::size_t chunk = 0; chunk < chunk_count; ++chunk) {
+        boundaries.emplace_back(iterator);
+
+        const auto chunk_size =
+            element_count / chunk_count + (chunk < element_count % chunk_count ? 1 : 0);
+
+        std::advance(iterator, static_cast<std::ptrdiff_t>(chunk_size));
+    }
+
+    boundaries.emplace_back(std::end(container));
+
+    const auto worker_count = std::min(thread_count, chunk_count);
+
+    // Identifiers can't be coordinated across chunks, so shared objects are repeated instead.
+    auto chunk_options = options;
+    if (chunk_options.shared_pointers == shared_pointer_policy::reference) {
+        chunk_options.shared_pointers = shared_pointer_policy::memoize;
+    }
+
+    std::vector<typename stream_type::string_type> fragments(chunk_count);
+    std::vector<std::exception_ptr> errors(worker_count);
+    std::atomic<std::size_t> next_chunk{ 0 };
+
+    const auto worker = [&](std::size_t worker_index) {
+        try {
+            stream_type stream;
+            writer_type writer{ stream };
+            writer.set_options(chunk_options);
+
+            for (auto chunk = next_chunk++; chunk < chunk_count; chunk = next_chunk++) {
+                stream.clear();
+                writer.Reset(stream);
+
+                write_elements(writer, boundaries[chunk], boundaries[chunk + 1], is_object);
+                fragments[chunk] = stream.release();
+            }
+        } catch (...) {
+            errors[worker_index] = std::current_exception();
+            next_chunk = chunk_count;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(worker_count - 1);
+
+    try {
+        for (std::size_t index = 1; index < worker_count; ++index) {
+            threads.emplace_back(worker, index);
+        }
+    } catch (...) {
+        // If we can't spawn as many threads as requested, the threads that we did manage to spawn
+        // (including the current one) will still work through all of the chunks.
+    }
+
+    worker(0);
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (const auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    // A chunk whose members were all omitted (see `serialization_options::omit_null_members`) is
+    // written as an empty container, which contributes neither members nor a separator.
+    const auto is_empty = [](const typename stream_type::string_type& fragment) {
+        return fragment.size() == 2;
+    };
+
+    const auto first_fragment = std::find_if_not(fragments.begin(), fragments.end(), is_empty);
+    if (first_fragment == fragments.end()) {
+        return std::move(fragments.front());
+    }
+
+    constexpr auto suffix_length = closing_length<writer_type>();
+
+    std::size_t total_size = 1 + suffix_length;
+    for (const auto& fragment : fragments) {
+        total_size += fragment.size() - suffix_length;
+    }
+
+    std::basic_string<typename OutputEncodingType::Ch> result;
+    result.reserve(total_size);
+    result.push_back(first_fragment->front());
+
+    const typename stream_type::string_type* last_fragment = nullptr;
+    for (const auto& fragment : fragments) {
+        if (is_empty(fragment)) {
+            continue;
+        }
+
+        if (last_fragment != nullptr) {
+            result.push_back(',');
+        }
+
+        result.append(fragment, 1, fragment.size() - 1 - suffix_length);
+        last_fragment = &fragment;
+    }
+
+    result.append(*last_fragment, last_fragment->size() - suffix_length, suffix_length);
+
+    return result;
+}
+} // namespace detail
+
+/**
+ * Serializes a container that maps to either a JSON array or a JSON object using multiple threads.
+ * The output is identical to that of `serialize_to_json(...)`.
+ *
+ * @param thread_count          The maximum number of threads to use, including the calling thread.
+ *                              A value of zero uses one thread per hardware thread.
+ *
+ * @note Elements are serialized concurrently, so any custom `to_json(...)` overloads must be safe
+ * to call from multiple threads at once.
+ **/
+template <
+    typename InputEncodingType = rapidjson::UTF8<>, typename OutputEncodingType = rapidjson::UTF8<>,
+    typename ContainerType>
+JSON_UTILS_NODISCARD std::basic_string<typename OutputEncodingType::Ch> serialize_to_json_parallel(
+    const ContainerType& container, std::size_t thread_count = 0,
+    const serialization_options& options = {})
+{
+    return detail::serialize_in_parallel<
+        json_utils::writer, InputEncodingType, OutputEncodingType>(
+        container, thread_count, options);
+}
+
+/**
+ * The pretty-printed counterpart to `serialize_to_json_parallel(...)`.
+ **/
+template <
+    typename InputEncodingType = rapidjson::UTF8<>, typename OutputEncodingType = rapidjson::UTF8<>,
+    typename ContainerType>
+JSON_UTILS_NODISCARD std::basic_string<typename OutputEncodingType::Ch>
+serialize_to_pretty_json_parallel(
+    const ContainerType& container, std::size_t thread_count = 0,
+    const serialization_options& options = {})
+{
+    return detail::serialize_in_parallel<
+        json_utils::pretty_writer, InputEncodingType, OutputEncodingType>(
+        container, thread_count, options);
+}
+} // namespace json_utils
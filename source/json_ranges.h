@@ -0,0 +1,304 @@
+#pragma once
+
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+namespace json_utils
+{
+namespace detail
+{
+/**
+ * Holds on to a range that was passed as an rvalue (e.g., a temporary view), so that it outlives
+ * the call in which it was wrapped.
+ *
+ * @note The range is mutable, since views such as filters can often only be iterated over when
+ * they aren't const.
+ **/
+template <typename RangeType> class range_holder
+{
+  public:
+    explicit range_holder(RangeType&& range) : m_range{ std::move(range) }
+    {
+    }
+
+    RangeType& get() const noexcept
+    {
+        return m_range;
+    }
+
+  private:
+    mutable RangeType m_range;
+};
+
+/**
+ * Refers to a range that was passed as an lvalue, which the caller keeps alive.
+ **/
+template <typename RangeType> class range_holder<RangeType&>
+{
+  public:
+    explicit range_holder(RangeType& range) noexcept : m_range{ &range }
+    {
+    }
+
+    RangeType& get() const noexcept
+    {
+        return *m_range;
+    }
+
+  private:
+    RangeType* m_range;
+};
+
+struct pair_key_projection
+{
+    template <typename PairType>
+    auto operator()(const PairType& pair) const noexcept -> decltype((pair.first))
+    {
+        return pair.first;
+    }
+};
+
+struct pair_value_projection
+{
+    template <typename PairType>
+    auto operator()(const PairType& pair) const noexcept -> decltype((pair.second))
+    {
+        return pair.second;
+    }
+};
+} // namespace detail
+
+/**
+ * An iterator paired with a sentinel, which may be of a different type than the iterator.
+ **/
+template <typename IteratorType, typename SentinelType> class iterator_range
+{
+  public:
+    iterator_range(IteratorType first, SentinelType last)
+        : m_first{ std::move(first) }, m_last{ std::move(last) }
+    {
+    }
+
+    IteratorType begin() const
+    {
+        return m_first;
+    }
+
+    SentinelType end() const
+    {
+        return m_last;
+    }
+
+  private:
+    IteratorType m_first;
+    SentinelType m_last;
+};
+
+/**
+ * Serializes the elements of any range as a JSON array, without requiring the range to be a
+ * container. Construct it via `json_utils::as_array(...)`.
+ **/
+template <typename RangeType> class array_range
+{
+  public:
+    explicit array_range(RangeType&& range) : m_range{ std::forward<RangeType>(range) }
+    {
+    }
+
+    auto& range() const noexcept
+    {
+        return m_range.get();
+    }
+
+  private:
+    detail::range_holder<RangeType> m_range;
+};
+
+/**
+ * Serializes the elements of any range as the members of a JSON object, with the key and the value
+ * of each member projected out of the element. Construct it via `json_utils::as_object(...)`.
+ *
+ * @note The projections may return temporaries, which only live until their member is written.
+ * Their contents are therefore always copied into the output, even by streams that could refer to
+ * it instead (see `stable_string`).
+ **/
+template <typename RangeType, typename KeyProjectionType, typename ValueProjectionType>
+class object_range
+{
+  public:
+    object_range(
+        RangeType&& range, KeyProjectionType key_projection, ValueProjectionType value_projection)
+        : m_range{ std::forward<RangeType>(range) },
+          m_key_projection{ std::move(key_projection) },
+          m_value_projection{ std::move(value_projection) }
+    {
+    }
+
+    auto& range() const noexcept
+    {
+        return m_range.get();
+    }
+
+    const KeyProjectionType& key_projection() const noexcept
+    {
+        return m_key_projection;
+    }
+
+    const ValueProjectionType& value_projection() const noexcept
+    {
+        return m_value_projection;
+    }
+
+  private:
+    detail::range_holder<RangeType> m_range;
+    KeyProjectionType m_key_projection;
+    ValueProjectionType m_value_projection;
+};
+
+/**
+ * Serializes the values produced by a generator as a JSON array. The generator is called with a
+ * callable that it should pass each element to, in order. Construct it via
+ * `json_utils::generate_array(...)`.
+ *
+ * @note The generator is called every time that the array is serialized, and twice when the output
+ * is measured first (see `json_utils::exact_size`), so it must produce the same elements each time.
+ **/
+template <typename GeneratorType> class generated_array
+{
+  public:
+    explicit generated_array(GeneratorType generator) : m_generator{ std::move(generator) }
+    {
+    }
+
+    GeneratorType& generator() const noexcept
+    {
+        return m_generator;
+    }
+
+  private:
+    mutable GeneratorType m_generator;
+};
+
+/**
+ * Serializes the key-value pairs produced by a generator as a JSON object. The generator is called
+ * with a callable that it should pass each key and value to. Construct it via
+ * `json_utils::generate_object(...)`.
+ *
+ * @note As with `generated_array`, the generator must produce the same members every time that it
+ * is called.
+ **/
+template <typename GeneratorType> class generated_object
+{
+  public:
+    explicit generated_object(GeneratorType generator) : m_generator{ std::move(generator) }
+    {
+    }
+
+    GeneratorType& generator() const noexcept
+    {
+        return m_generator;
+    }
+
+  private:
+    mutable GeneratorType m_generator;
+};
+
+/**
+ * Wraps a range (such as a container, or a filtered or transformed view) so that its elements are
+ * serialized as a JSON array.
+ *
+ * @note Lvalue ranges are referred to, and must outlive the wrapper, while rvalue ranges are moved
+ * into the wrapper.
+ **/
+template <typename RangeType> array_range<RangeType> as_array(RangeType&& range)
+{
+    return array_range<RangeType>{ std::forward<RangeType>(range) };
+}
+
+/**
+ * Wraps an iterator and a sentinel so that the elements in between them are serialized as a JSON
+ * array.
+ **/
+template <typename IteratorType, typename SentinelType>
+array_range<iterator_range<IteratorType, SentinelType>>
+as_array(IteratorType first, SentinelType last)
+{
+    using range_type = iterator_range<IteratorType, SentinelType>;
+    return as_array(range_type{ std::move(first), std::move(last) });
+}
+
+/**
+ * Wraps a range of key-value pairs so that it is serialized as a JSON object.
+ **/
+template <typename RangeType>
+object_range<RangeType, detail::pair_key_projection, detail::pair_value_projection>
+as_object(RangeType&& range)
+{
+    return { std::forward<RangeType>(range), {}, {} };
+}
+
+/**
+ * Wraps a range so that it is serialized as a JSON object, with each element of the range becoming
+ * a member whose key and value are obtained by invoking the projections on the element.
+ *
+ * @param key_projection         Returns a key, which can be of any type that is accepted as the
+ *                               key of a serialized map.
+ * @param value_projection       Returns a value, which can be of any serializable type.
+ **/
+template <typename RangeType, typename KeyProjectionType, typename ValueProjectionType>
+object_range<RangeType, KeyProjectionType, ValueProjectionType>
+as_object(RangeType&& range, KeyProjectionType key_projection, ValueProjectionType value_projection)
+{
+    return { std::forward<RangeType>(range), std::move(key_projection),
+             std::move(value_projection) };
+}
+
+/**
+ * Wraps an iterator and a sentinel so that the elements in between them are serialized as a JSON
+ * object, as described above.
+ **/
+template <
+    typename IteratorType, typename SentinelType, typename KeyProjectionType,
+    typename ValueProjectionType>
+object_range<iterator_range<IteratorType, SentinelType>, KeyProjectionType, ValueProjectionType>
+as_object(
+    IteratorType first, SentinelType last, KeyProjectionType key_projection,
+    ValueProjectionType value_projection)
+{
+    return { iterator_range<IteratorType, SentinelType>{ std::move(first), std::move(last) },
+             std::move(key_projection), std::move(value_projection) };
+}
+
+/**
+ * Serializes the values that a generator produces as a JSON array, without storing them first:
+ *
+ * @code
+ * json_utils::serialize_to_json(json_utils::generate_array([&](auto&& emit) {
+ *     for (const auto& entry : index) {
+ *         if (entry.is_live()) {
+ *             emit(entry.id());
+ *         }
+ *     }
+ * }));
+ * @endcode
+ **/
+template <typename GeneratorType>
+generated_array<std::decay_t<GeneratorType>> generate_array(GeneratorType&& generator)
+{
+    return generated_array<std::decay_t<GeneratorType>>{ std::forward<GeneratorType>(generator) };
+}
+
+/**
+ * Serializes the key-value pairs that a generator produces, by calling `emit(key, value)`, as a
+ * JSON object.
+ *
+ * @note As with `as_object(...)`, emitted values may be temporaries, and are therefore copied into
+ * the output as soon as they're emitted, rather than referenced.
+ **/
+template <typename GeneratorType>
+generated_object<std::decay_t<GeneratorType>> generate_object(GeneratorType&& generator)
+{
+    return generated_object<std::decay_t<GeneratorType>>{ std::forward<GeneratorType>(generator) };
+}
+} // namespace json_utils
@@ -0,0 +1,246 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include <rapidjson/error/en.h>
+#include <rapidjson/reader.h>
+
+#include "json_serializer.h"
+
+namespace json_utils
+{
+namespace detail
+{
+/**
+ * Forwards the events of a rapidjson reader to a writer, while providing the handlers that the
+ * reader requires but that not every writer implements (such as `RawNumber(...)`).
+ **/
+template <typename WriterType>
+class sax_forwarder
+    : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, sax_forwarder<WriterType>>
+{
+  public:
+    using Ch = char;
+
+    explicit sax_forwarder(WriterType& writer) noexcept : m_writer{ writer }
+    {
+    }
+
+    bool Null()
+    {
+        return m_writer.Null();
+    }
+
+    bool Bool(bool value)
+    {
+        return m_writer.Bool(value);
+    }
+
+    bool Int(int value)
+    {
+        return m_writer.Int(value);
+    }
+
+    bool Uint(unsigned value)
+    {
+        return m_writer.Uint(value);
+    }
+
+    bool Int64(std::int64_t value)
+    {
+        return m_writer.Int64(value);
+    }
+
+    bool Uint64(std::uint64_t value)
+    {
+        return m_writer.Uint64(value);
+    }
+
+    bool Double(double value)
+    {
+        return m_writer.Double(value);
+    }
+
+    bool String(const Ch* value, rapidjson::SizeType length, bool copy)
+    {
+        return m_writer.String(value, length, copy);
+    }
+
+    bool StartObject()
+    {
+        return m_writer.StartObject();
+    }
+
+    bool Key(const Ch* value, rapidjson::SizeType length, bool copy)
+    {
+        return m_writer.Key(value, length, copy);
+    }
+
+    bool EndObject(rapidjson::SizeType member_count)
+    {
+        return m_writer.EndObject(member_count);
+    }
+
+    bool StartArray()
+    {
+        return m_writer.StartArray();
+    }
+
+    bool EndArray(rapidjson::SizeType element_count)
+    {
+        return m_writer.EndArray(element_count);
+    }
+
+  private:
+    WriterType& m_writer;
+};
+} // namespace detail
+
+/**
+ * Holds a value that is already serialized (e.g., a cached sub-response, or a payload received from
+ * an upstream service), so that it can be embedded in a larger document without first being parsed
+ * into a DOM:
+ *
+ * @code
+ * std::map<std::string, json_utils::raw_json> response;
+ * response.emplace("profile", json_utils::raw_json{ cache.get(user_id) });
+ * response.emplace("settings", json_utils::raw_json::validated(upstream.fetch()));
+ * @endcode
+ *
+ * Compact, narrow writers copy the text into the output verbatim. Every other writer (e.g., pretty
+ * writers, those that produce MessagePack, or the `hash_writer`) parses the text and writes the
+ * resultant values as it would any others.
+ *
+ * @note The text is not validated unless that is requested, since the point of this wrapper is to
+ * avoid parsing JSON that is already known to be well-formed.
+ **/
+class raw_json
+{
+  public:
+    raw_json() : m_json{ "null" }
+    {
+    }
+
+    explicit raw_json(std::string json) noexcept : m_json{ std::move(json) }
+    {
+    }
+
+    /**
+     * @throws std::invalid_argument if the text isn't a single, well-formed JSON value.
+     **/
+    static raw_json validated(std::string json)
+    {
+        raw_json result{ std::move(json) };
+        result.validate();
+
+        return result;
+    }
+
+    /**
+     * Checks that the text is a single, well-formed JSON value, without building a DOM.
+     **/
+    bool is_valid() const
+    {
+        rapidjson::BaseReaderHandler<> handler;
+        return !parse(handler).IsError();
+    }
+
+    /**
+     * @throws std::invalid_argument if the text isn't a single, well-formed JSON value.
+     **/
+    void validate() const
+    {
+        rapidjson::BaseReaderHandler<> handler;
+        throw_on_error(parse(handler));
+    }
+
+    /**
+     * Writes the values that make up the text to a writer.
+     *
+     * @throws std::invalid_argument if the text isn't a single, well-formed JSON value.
+     **/
+    template <typename WriterType> void replay(WriterType& writer) const
+    {
+        detail::sax_forwarder<WriterType> forwarder{ writer };
+        throw_on_error(parse(forwarder));
+    }
+
+    const std::string& str() const noexcept
+    {
+        return m_json;
+    }
+
+    const char* data() const noexcept
+    {
+        return m_json.data();
+    }
+
+    std::size_t size() const noexcept
+    {
+        return m_json.size();
+    }
+
+  private:
+    template <typename HandlerType> rapidjson::ParseResult parse(HandlerType& handler) const
+    {
+        rapidjson::StringStream stream{ m_json.c_str() };
+        rapidjson::Reader reader;
+
+        auto result = reader.Parse<rapidjson::kParseFullPrecisionFlag>(stream, handler);
+
+        // The stream stops at the first null character, which need not be the end of the string.
+        if (!result.IsError() && stream.Tell() != m_json.size()) {
+            result.Set(rapidjson::kParseErrorDocumentRootNotSingular, stream.Tell());
+        }
+
+        return result;
+    }
+
+    static void throw_on_error(const rapidjson::ParseResult& result)
+    {
+        if (!result.IsError()) {
+            return;
+        }
+
+        const auto* const error = rapidjson::GetParseError_En(result.Code());
+        const auto offset = std::to_string(result.Offset());
+
+        throw std::invalid_argument{ std::string{ "Invalid raw JSON: " } + error + " at offset " +
+                                     offset + "." };
+    }
+
+    std::string m_json;
+};
+
+namespace serializer
+{
+namespace detail
+{
+template <typename WriterType>
+void write_raw_value(WriterType& writer, const raw_json& data, std::true_type)
+{
+    writer.RawValue(data.data(), data.size(), rapidjson::kObjectType);
+}
+
+template <typename WriterType>
+void write_raw_value(WriterType& writer, const raw_json& data, std::false_type)
+{
+    data.replay(writer);
+}
+
+template <typename WriterType> void to_json(WriterType& writer, const raw_json& data)
+{
+    static_assert(
+        std::is_same<typename WriterType::Ch, char>::value,
+        "Raw JSON can only be written by a narrow character writer.");
+
+    write_raw_value(writer, data, can_splice_raw_json<WriterType>{});
+}
+} // namespace detail
+} // namespace serializer
+} // namespace json_utils
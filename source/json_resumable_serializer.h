@@ -0,0 +1,309 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "json_output_streams.h"
+#include "json_serialization_options.h"
+#include "json_serializer.h"
+#include "json_writer.h"
+
+namespace json_utils
+{
+struct produce_result
+{
+    /**
+     * The number of bytes written to the buffer passed to `produce(...)`.
+     **/
+    std::size_t bytes_written;
+
+    /**
+     * Whether the document has been written out in its entirety.
+     **/
+    bool done;
+};
+
+namespace detail
+{
+template <typename ContextType> class resumable_frame
+{
+  public:
+    virtual ~resumable_frame() = default;
+
+    /**
+     * Writes the next token of the container (an opening bracket, an element, or the closing
+     * bracket) to the context's pending output.
+     *
+     * @returns False once the closing bracket has been written.
+     **/
+    virtual bool step(ContextType& context) = 0;
+};
+
+template <typename ContextType, typename DataType>
+void write_resumable_value(ContextType& context, const DataType& data);
+
+template <typename ContextType, typename ContainerType>
+class resumable_container_frame final : public resumable_frame<ContextType>
+{
+    static constexpr bool is_object = traits::treat_as_object_sink_v<ContainerType>;
+
+  public:
+    explicit resumable_container_frame(const ContainerType& container)
+        : m_position{ std::begin(container) }, m_end{ std::end(container) }
+    {
+    }
+
+    bool step(ContextType& context) override
+    {
+        if (m_state == state::unopened) {
+            m_state = state::opened;
+            context.put(is_object ? '{' : '[');
+            return true;
+        }
+
+        if (m_position == m_end) {
+            context.put(is_object ? '}' : ']');
+            return false;
+        }
+
+        const auto& element = *m_position;
+        ++m_position;
+
+        if (is_omitted(context, element, std::integral_constant<bool, is_object>{})) {
+            return true;
+        }
+
+        if (m_state == state::in_progress) {
+            context.put(',');
+        }
+
+        m_state = state::in_progress;
+
+        write_element(context, element, std::integral_constant<bool, is_object>{});
+
+        return true;
+    }
+
+  private:
+    enum class state
+    {
+        unopened,
+        opened,
+        in_progress
+    };
+
+    template <typename ElementType>
+    static bool
+    is_omitted(ContextType& /*context*/, const ElementType& /*element*/, std::false_type)
+    {
+        return false;
+    }
+
+    template <typename ElementType>
+    static bool is_omitted(ContextType& context, const ElementType& element, std::true_type)
+    {
+        return serializer::detail::is_omitted_member(
+            context.writer.get_options(), element.second);
+    }
+
+    template <typename ElementType>
+    static void write_element(ContextType& context, const ElementType& element, std::false_type)
+    {
+        write_resumable_value(context, element);
+    }
+
+    template <typename ElementType>
+    static void write_element(ContextType& context, const ElementType& element, std::true_type)
+    {
+        context.write_key(element.first);
+        context.put(':');
+
+        write_resumable_value(context, element.second);
+    }
+
+    decltype(std::begin(std::declval<const ContainerType&>())) m_position;
+    decltype(std::end(std::declval<const ContainerType&>())) m_end;
+    state m_state = state::unopened;
+};
+
+/**
+ * Holds output until it is produced, after which it is discarded. Shared objects therefore can't be
+ * replayed from it; it is a type of its own, so that the writer keeps its own copy of them instead.
+ **/
+template <typename EncodingType>
+class pending_output_stream : public string_output_stream<EncodingType>
+{
+};
+
+template <typename InputEncodingType, typename OutputEncodingType> struct resumable_context
+{
+    using stream_type = string_output_stream<OutputEncodingType>;
+    using pending_stream_type = pending_output_stream<OutputEncodingType>;
+
+    using writer_type = json_utils::writer<stream_type, InputEncodingType, OutputEncodingType>;
+    using pending_writer_type =
+        json_utils::writer<pending_stream_type, InputEncodingType, OutputEncodingType>;
+
+    void put(char character)
+    {
+        pending.Put(static_cast<typename stream_type::Ch>(character));
+    }
+
+    /**
+     * Every leaf is written as a value of its own, but the shared objects written so far are
+     * remembered across leaves, as they would be in `serializer::to_json(...)`.
+     **/
+    template <typename DataType> void write_leaf(const DataType& data)
+    {
+        writer.start_value(pending);
+        serializer::to_json(writer, data);
+    }
+
+    /**
+     * Keys are formatted by exactly the same logic as in `serializer::to_json(...)`, using a writer
+     * that has an object open; the opening brace is then dropped.
+     **/
+    template <typename KeyType> void write_key(const KeyType& key)
+    {
+        key_scratch.clear();
+        key_writer.Reset(key_scratch);
+        key_writer.StartObject();
+
+        serializer::detail::insert_key(key_writer, key);
+
+        pending.write(key_scratch.str().data() + 1, key_scratch.size() - 1);
+    }
+
+    template <typename ContainerType> void push(const ContainerType& container)
+    {
+        frames.emplace_back(
+            std::make_unique<resumable_container_frame<resumable_context, ContainerType>>(
+                container));
+    }
+
+    pending_stream_type pending;
+    std::size_t pending_offset = 0;
+    pending_writer_type writer{ pending };
+
+    stream_type key_scratch;
+    writer_type key_writer{ key_scratch };
+
+    std::vector<std::unique_ptr<resumable_frame<resumable_context>>> frames;
+};
+
+template <typename ContextType, typename DataType>
+void write_resumable_value(ContextType& context, const DataType& data, std::true_type)
+{
+    context.push(data);
+}
+
+template <typename ContextType, typename DataType>
+void write_resumable_value(ContextType& context, const DataType& data, std::false_type)
+{
+    context.write_leaf(data);
+}
+
+/**
+ * Containers that map onto JSON arrays or objects are traversed incrementally, one element at a
+ * time. Everything else (including custom types) is written out in one go.
+ **/
+template <typename ContextType, typename DataType>
+void write_resumable_value(ContextType& context, const DataType& data)
+{
+    using is_container = std::integral_constant<
+        bool, traits::treat_as_array_sink_v<DataType> || traits::treat_as_object_sink_v<DataType>>;
+
+    write_resumable_value(context, data, is_container{});
+}
+} // namespace detail
+
+/**
+ * A serializer that can be paused whenever the destination can't accept more data, and resumed
+ * later, without ever blocking a thread. Each call to `produce(...)` fills as much of the provided
+ * buffer as it can, and then returns.
+ *
+ * Containers that map onto JSON arrays or objects are walked using an explicit stack of iterators,
+ * so that only a single element (or, for nested containers, a single element per level) is ever
+ * held in memory in serialized form.
+ *
+ * @note The serializer refers to the data passed to its constructor, which must outlive it. The
+ * output is always compact.
+ **/
+template <
+    typename InputEncodingType = rapidjson::UTF8<>, typename OutputEncodingType = rapidjson::UTF8<>>
+class resumable_serializer
+{
+    static_assert(
+        sizeof(typename OutputEncodingType::Ch) == 1,
+        "Resumable serialization requires a narrow character encoding.");
+
+  public:
+    template <typename DataType>
+    explicit resumable_serializer(
+        const DataType& data, const serialization_options& options = {})
+    {
+        m_context.writer.set_options(options);
+        m_context.key_writer.set_options(options);
+        detail::write_resumable_value(m_context, data);
+    }
+
+    resumable_serializer(const resumable_serializer&) = delete;
+    resumable_serializer& operator=(const resumable_serializer&) = delete;
+
+    /**
+     * Writes as much of the remaining output as fits into the buffer.
+     **/
+    produce_result produce(char* buffer, std::size_t capacity)
+    {
+        std::size_t written = 0;
+
+        while (written < capacity) {
+            const auto& pending = m_context.pending.str();
+
+            if (m_context.pending_offset == pending.size()) {
+                if (m_context.frames.empty()) {
+                    break;
+                }
+
+                m_context.pending.clear();
+                m_context.pending_offset = 0;
+
+                advance();
+                continue;
+            }
+
+            const auto count =
+                std::min(capacity - written, pending.size() - m_context.pending_offset);
+
+            std::copy_n(pending.data() + m_context.pending_offset, count, buffer + written);
+
+            m_context.pending_offset += count;
+            written += count;
+        }
+
+        return { written, done() };
+    }
+
+    bool done() const noexcept
+    {
+        return m_context.frames.empty() &&
+               m_context.pending_offset == m_context.pending.size();
+    }
+
+  private:
+    void advance()
+    {
+        auto& frame = *m_context.frames.back();
+
+        if (!frame.step(m_context)) {
+            m_context.frames.pop_back();
+        }
+    }
+
+    detail::resumable_context<InputEncodingType, OutputEncodingType> m_context;
+};
+} // namespace json_utils
@@ -5,6 +5,8 @@
 #include <rapidjson/error/en.h>
 #include <rapidjson/reader.h>
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <stdexcept>
@@ -679,6 +681,19 @@ void parse_stream(StreamType& stream, ContainerType& container)
     }
 }
 
+/**
+ * Drives the handler stack with the events produced by a binary format reader (e.g., the
+ * `msgpack_reader` or the `cbor_reader`), rather than by `rapidjson::Reader`.
+ **/
+template <typename ContainerType, typename ReaderType>
+ContainerType from_binary(const std::uint8_t* const data, std::size_t size)
+{
+    delegating_handler<ContainerType, rapidjson::UTF8<>> handler;
+    ReaderType{}.parse(data, size, handler);
+
+    return std::move(*handler.get_container());
+}
+
 template <
     typename ContainerType, unsigned int ParseFlags = rapidjson::ParseFlag::kParseDefaultFlags>
 ContainerType from_json(const char* const json)
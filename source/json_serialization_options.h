@@ -0,0 +1,212 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace json_utils
+{
+/**
+ * Describes how floating-point numbers are to be written.
+ *
+ * - `shortest()` writes the shortest representation that round-trips to the original value. A
+ *   `float` is formatted as a `float`, so `0.1f` is written as `0.1`, rather than as the 17
+ *   significant digits required to represent the value after promotion to `double`.
+ *
+ * - `fixed(n)` always writes exactly `n` digits after the decimal point, rounding as needed.
+ *
+ * - `max_decimal_places(n)` writes the shortest representation, but truncates it after `n` decimal
+ *   places, dropping any trailing zeros that remain. This is rapidjson's own
+ *   `Writer::SetMaxDecimalPlaces(...)` behaviour.
+ **/
+class number_format
+{
+  public:
+    enum class style
+    {
+        shortest,
+        fixed,
+        max_decimal_places
+    };
+
+    static constexpr int max_precision = 17;
+
+    static constexpr number_format shortest() noexcept
+    {
+        return number_format{ style::shortest, 0 };
+    }
+
+    static number_format fixed(int decimal_places)
+    {
+        if (decimal_places < 0 || decimal_places > max_precision) {
+            throw std::invalid_argument{ "Fixed precision must be between 0 and 17." };
+        }
+
+        return number_format{ style::fixed, decimal_places };
+    }
+
+    static number_format max_decimal_places(int decimal_places)
+    {
+        if (decimal_places < 1) {
+            throw std::invalid_argument{ "At least one decimal place must be allowed." };
+        }
+
+        return number_format{ style::max_decimal_places, decimal_places };
+    }
+
+    constexpr style get_style() const noexcept
+    {
+        return m_style;
+    }
+
+    constexpr int get_decimal_places() const noexcept
+    {
+        return m_decimal_places;
+    }
+
+  private:
+    constexpr number_format(style format_style, int decimal_places) noexcept
+        : m_style{ format_style }, m_decimal_places{ decimal_places }
+    {
+    }
+
+    style m_style;
+    int m_decimal_places;
+};
+
+/**
+ * Describes how an object that is owned by several `std::shared_ptr<...>` instances is written.
+ *
+ * - `expand` serializes the object every time that it is encountered.
+ *
+ * - `memoize` serializes each object that has more than one owner only once per call, and replays
+ *   its JSON whenever the object is encountered again. The output is the same as with `expand`.
+ *
+ * - `reference` writes each object in full only once, with an additional `"$id"` member, and writes
+ *   `{"$ref":<id>}` in place of every later occurrence, which also allows for cycles. Objects that
+ *   aren't serialized as JSON objects are memoized instead.
+ *
+ * @note Replaying JSON requires a compact, narrow writer. Pretty and wide writers still honour
+ * `reference`, but serialize objects that aren't JSON objects again, and expand every object under
+ * `memoize`.
+ **/
+enum class shared_pointer_policy
+{
+    expand,
+    memoize,
+    reference
+};
+
+/**
+ * Maps the keys of object members onto (typically shorter) aliases that are written in their place,
+ * for instance:
+ *
+ * @code
+ * const json_utils::key_alias_table aliases{ { "temperature", "t" }, { "timestamp", "ts" } };
+ * @endcode
+ *
+ * @note Aliases are applied to narrow keys only, and are looked up without allocating.
+ **/
+class key_alias_table
+{
+  public:
+    key_alias_table() = default;
+
+    key_alias_table(std::initializer_list<std::pair<std::string, std::string>> aliases)
+    {
+        for (const auto& alias : aliases) {
+            add(alias.first, alias.second);
+        }
+    }
+
+    /**
+     * Registers an alias, or replaces the alias that is already registered for the key.
+     **/
+    void add(std::string key, std::string alias)
+    {
+        const auto index = lower_bound(key.data(), key.size());
+        if (index != m_aliases.size() && m_aliases[index].first == key) {
+            m_aliases[index].second = std::move(alias);
+            return;
+        }
+
+        m_aliases.emplace(
+            m_aliases.begin() + static_cast<std::ptrdiff_t>(index), std::move(key),
+            std::move(alias));
+    }
+
+    /**
+     * @returns The alias of the key, or null if no alias is registered for it.
+     **/
+    const std::string* find(const char* key, std::size_t length) const noexcept
+    {
+        const auto index = lower_bound(key, length);
+        if (index == m_aliases.size() || compare(m_aliases[index].first, key, length) != 0) {
+            return nullptr;
+        }
+
+        return &m_aliases[index].second;
+    }
+
+    bool empty() const noexcept
+    {
+        return m_aliases.empty();
+    }
+
+  private:
+    static int compare(const std::string& lhs, const char* rhs, std::size_t length) noexcept
+    {
+        return lhs.compare(0, lhs.size(), rhs, length);
+    }
+
+    /**
+     * @returns The index of the first alias whose key doesn't sort before the given key.
+     **/
+    std::size_t lower_bound(const char* key, std::size_t length) const noexcept
+    {
+        const auto position = std::lower_bound(
+            m_aliases.begin(), m_aliases.end(), key,
+            [length](const std::pair<std::string, std::string>& alias, const char* data) {
+                return compare(alias.first, data, length) < 0;
+            });
+
+        return static_cast<std::size_t>(position - m_aliases.begin());
+    }
+
+    // Sorted by key, so that keys can be looked up by pointer and length.
+    std::vector<std::pair<std::string, std::string>> m_aliases;
+};
+
+/**
+ * Per-call settings that are carried by `json_utils::writer<...>` and
+ * `json_utils::pretty_writer<...>`, and that are consulted by the `to_json(...)` overloads as the
+ * data is written out.
+ **/
+struct serialization_options
+{
+    number_format numbers = number_format::shortest();
+    shared_pointer_policy shared_pointers = shared_pointer_policy::expand;
+
+    /**
+     * Skips the members of objects whose values would be written as `null`, such as empty
+     * `std::optional<...>` instances and null pointers.
+     **/
+    bool omit_null_members = false;
+
+    /**
+     * Skips the members of objects whose values equal a default-constructed value, such as zeros,
+     * empty strings and containers, and null pointers.
+     **/
+    bool omit_default_members = false;
+
+    /**
+     * Keys to be replaced as they are written, if any. The table isn't copied, and must outlive
+     * every call that uses these options.
+     **/
+    const key_alias_table* key_aliases = nullptr;
+};
+} // namespace json_utils
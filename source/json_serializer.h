@@ -1,6 +1,19 @@
 #pragma once
 
 #include "json_fwd.h"
+#include "json_output_streams.h"
+#include "json_ranges.h"
+#include "json_writer.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
 
 namespace json_utils
 {
@@ -49,6 +62,52 @@ inline std::wstring to_wide_json_key(const std::wstring& data) noexcept
     return data;
 }
 
+/**
+ * A fixed-capacity, stack-allocated buffer into which non-string keys can be formatted.
+ *
+ * To serialize a custom key type without allocating a temporary string for every key, provide a
+ * `to_json_key(...)` overload in the same namespace as the key type (so that it can be found via
+ * ADL), and append the formatted key to the buffer:
+ *
+ * @code
+ * void to_json_key(json_utils::serializer::key_buffer<char>& buffer, const my_key& key);
+ * @endcode
+ **/
+template <typename CharacterType> class key_buffer
+{
+  public:
+    static constexpr std::size_t capacity = 128;
+
+    void append(const CharacterType* data, std::size_t length)
+    {
+        if (RAPIDJSON_UNLIKELY(length > capacity - m_size)) {
+            throw std::length_error{ "Key exceeds the capacity of the key buffer." };
+        }
+
+        std::char_traits<CharacterType>::copy(m_data + m_size, data, length);
+        m_size += length;
+    }
+
+    void push_back(CharacterType character)
+    {
+        append(&character, 1);
+    }
+
+    const CharacterType* data() const noexcept
+    {
+        return m_data;
+    }
+
+    std::size_t size() const noexcept
+    {
+        return m_size;
+    }
+
+  private:
+    CharacterType m_data[capacity];
+    std::size_t m_size = 0;
+};
+
 namespace detail
 {
 template <typename CharacterType> struct locksmith
@@ -73,10 +132,316 @@ template <> struct locksmith<wchar_t>
     }
 };
 
+template <std::size_t Rank> struct overload_rank : overload_rank<Rank - 1>
+{
+};
+
+template <> struct overload_rank<0>
+{
+};
+
+template <typename, typename = void> struct has_get_options : std::false_type
+{
+};
+
+template <typename WriterType>
+struct has_get_options<
+    WriterType, future_std::void_t<decltype(std::declval<const WriterType&>().get_options())>>
+    : std::true_type
+{
+};
+
+template <typename WriterType>
+const serialization_options& options_of(const WriterType& writer, std::true_type) noexcept
+{
+    return writer.get_options();
+}
+
+template <typename WriterType>
+const serialization_options& options_of(const WriterType& /*writer*/, std::false_type) noexcept
+{
+    static const serialization_options defaults;
+    return defaults;
+}
+
+/**
+ * @returns The options carried by the writer, or the default options if it doesn't carry any.
+ **/
+template <typename WriterType>
+const serialization_options& options_of(const WriterType& writer) noexcept
+{
+    return options_of(writer, has_get_options<WriterType>{});
+}
+
+template <typename WriterType>
+void write_aliased_key(WriterType& writer, const char* data, std::size_t size, std::true_type)
+{
+    const auto* const aliases = writer.get_options().key_aliases;
+    if (aliases != nullptr) {
+        const auto* const alias = aliases->find(data, size);
+        if (alias != nullptr) {
+            data = alias->data();
+            size = alias->size();
+        }
+    }
+
+    writer.Key(data, static_cast<rapidjson::SizeType>(size));
+}
+
+template <typename WriterType>
+void write_aliased_key(
+    WriterType& writer, const typename WriterType::Ch* data, std::size_t size, std::false_type)
+{
+    writer.Key(data, static_cast<rapidjson::SizeType>(size));
+}
+
+/**
+ * Writes a key, or the alias that the writer's options register for it.
+ **/
+template <typename WriterType>
+void write_aliased_key(WriterType& writer, const typename WriterType::Ch* data, std::size_t size)
+{
+    using can_alias = std::integral_constant<
+        bool, std::is_same<typename WriterType::Ch, char>::value &&
+                  has_get_options<WriterType>::value>;
+
+    write_aliased_key(writer, data, size, can_alias{});
+}
+
+template <typename WriterType, typename CharacterTraits, typename Allocator>
+void insert_key(
+    WriterType& writer,
+    const std::basic_string<typename WriterType::Ch, CharacterTraits, Allocator>& key,
+    overload_rank<3>)
+{
+    write_aliased_key(writer, key.data(), key.size());
+}
+
+#if __cplusplus >= 201703L // C++17
+
+template <typename WriterType, typename CharacterTraits>
+void insert_key(
+    WriterType& writer, const std::basic_string_view<typename WriterType::Ch, CharacterTraits>& key,
+    overload_rank<3>)
+{
+    write_aliased_key(writer, key.data(), key.size());
+}
+
+#endif
+
+/**
+ * @note Selected when a `to_json_key(...)` overload can be found for the key type, allowing the key
+ * to be formatted into a stack buffer rather than into a temporary string.
+ **/
+template <typename WriterType, typename KeyType>
+auto insert_key(WriterType& writer, const KeyType& key, overload_rank<2>)
+    -> decltype(to_json_key(std::declval<key_buffer<typename WriterType::Ch>&>(), key), void())
+{
+    key_buffer<typename WriterType::Ch> buffer;
+    to_json_key(buffer, key);
+
+    write_aliased_key(writer, buffer.data(), buffer.size());
+}
+
+/**
+ * Formats an integer into the buffer, which must be able to hold its longest representation.
+ *
+ * @returns A pointer one past the last character written.
+ **/
+template <typename IntegerType> char* format_integer(char* buffer, IntegerType value) noexcept
+{
+#if __cplusplus >= 201703L // C++17
+    return std::to_chars(buffer, buffer + std::numeric_limits<IntegerType>::digits10 + 3, value)
+        .ptr;
+#else
+    using unsigned_type = std::make_unsigned_t<IntegerType>;
+
+    auto magnitude = static_cast<unsigned_type>(value);
+    if (value < IntegerType{ 0 }) {
+        *buffer++ = '-';
+        magnitude = static_cast<unsigned_type>(unsigned_type{ 0 } - magnitude);
+    }
+
+    char digits[std::numeric_limits<unsigned_type>::digits10 + 1];
+    char* digit = std::end(digits);
+
+    do {
+        *--digit = static_cast<char>('0' + magnitude % 10);
+        magnitude = static_cast<unsigned_type>(magnitude / 10);
+    } while (magnitude != 0);
+
+    return std::copy(digit, std::end(digits), buffer);
+#endif
+}
+
+template <typename WriterType>
+void write_formatted_key(WriterType& writer, const char* data, std::size_t size, std::true_type)
+{
+    write_aliased_key(writer, data, size);
+}
+
+template <typename WriterType>
+void write_formatted_key(WriterType& writer, const char* data, std::size_t size, std::false_type)
+{
+    typename WriterType::Ch widened[std::numeric_limits<std::uint64_t>::digits10 + 3];
+    std::copy(data, data + size, widened);
+
+    writer.Key(widened, static_cast<rapidjson::SizeType>(size));
+}
+
+template <typename WriterType, typename IntegerType>
+void insert_integer_key(WriterType& writer, IntegerType key)
+{
+    char digits[std::numeric_limits<IntegerType>::digits10 + 3];
+    const auto size = static_cast<std::size_t>(format_integer(digits, key) - digits);
+
+    write_formatted_key(writer, digits, size, std::is_same<typename WriterType::Ch, char>{});
+}
+
+template <typename CharacterType, typename KeyType, typename = void>
+struct has_generated_key : std::false_type
+{
+};
+
+template <typename KeyType>
+struct has_generated_key<
+    char, KeyType,
+    future_std::void_t<decltype(to_narrow_json_key(std::declval<const KeyType&>()))>>
+    : std::true_type
+{
+};
+
+template <typename KeyType>
+struct has_generated_key<
+    wchar_t, KeyType,
+    future_std::void_t<decltype(to_wide_json_key(std::declval<const KeyType&>()))>>
+    : std::true_type
+{
+};
+
+/**
+ * @note Selected for integral keys, which are formatted on the stack rather than into a temporary
+ * string, and for enumerations, which are written as their underlying value. Keys for which a
+ * `to_json_key(...)`, `to_narrow_json_key(...)`, or `to_wide_json_key(...)` overload can be found
+ * are written by way of that overload instead.
+ **/
+template <typename WriterType, typename KeyType>
+auto insert_key(WriterType& writer, const KeyType& key, overload_rank<1>) -> std::enable_if_t<
+    traits::is_integer_key_v<KeyType> &&
+    !has_generated_key<typename WriterType::Ch, KeyType>::value>
+{
+    insert_integer_key(writer, key);
+}
+
+template <typename WriterType, typename KeyType>
+auto insert_key(WriterType& writer, const KeyType& key, overload_rank<1>) -> std::enable_if_t<
+    std::is_enum<KeyType>::value && !has_generated_key<typename WriterType::Ch, KeyType>::value>
+{
+    insert_integer_key(writer, static_cast<std::underlying_type_t<KeyType>>(key));
+}
+
+template <typename WriterType, typename KeyType>
+void insert_key(WriterType& writer, const KeyType& key, overload_rank<0>)
+{
+    const auto generated_key = locksmith<typename WriterType::Ch>::generate_key(key);
+    write_aliased_key(writer, generated_key.data(), generated_key.size());
+}
+
+/**
+ * Writes a key using the most specific of the `insert_key(...)` overloads above.
+ **/
+template <typename WriterType, typename KeyType>
+void insert_key(WriterType& writer, const KeyType& key)
+{
+    insert_key(writer, key, overload_rank<3>{});
+}
+
+/**
+ * @returns Whether the value is written as a `null`.
+ **/
+template <typename DataType> bool is_null_value(const DataType& /*data*/) noexcept
+{
+    return false;
+}
+
+inline bool is_null_value(std::nullptr_t /*data*/) noexcept
+{
+    return true;
+}
+
+inline bool is_null_value(const char* data) noexcept
+{
+    return data == nullptr;
+}
+
+inline bool is_null_value(const wchar_t* data) noexcept
+{
+    return data == nullptr;
+}
+
+template <typename DataType> bool is_null_value(const std::shared_ptr<DataType>& data) noexcept
+{
+    return data == nullptr;
+}
+
+template <typename DataType> bool is_null_value(const std::unique_ptr<DataType>& data) noexcept
+{
+    return data == nullptr;
+}
+
+template <typename DataType> bool is_null_value(const std::weak_ptr<DataType>& data) noexcept
+{
+    return data.expired();
+}
+
+#if __cplusplus >= 201703L // C++17
+
+template <typename DataType> bool is_null_value(const std::optional<DataType>& data) noexcept
+{
+    return !data.has_value();
+}
+
+#endif
+
+/**
+ * @note Selected for containers and strings, which are compared without constructing an instance.
+ **/
+template <typename DataType>
+auto is_default_value(const DataType& data, overload_rank<2>) -> decltype(data.empty(), bool())
+{
+    return data.empty();
+}
+
+template <typename DataType>
+auto is_default_value(const DataType& data, overload_rank<1>)
+    -> decltype(static_cast<bool>(data == DataType{}))
+{
+    return static_cast<bool>(data == DataType{});
+}
+
+template <typename DataType> bool is_default_value(const DataType& data, overload_rank<0>)
+{
+    return is_null_value(data);
+}
+
+/**
+ * @returns Whether the member with the given value is to be skipped, as per the writer's options.
+ **/
+template <typename DataType>
+bool is_omitted_member(const serialization_options& options, const DataType& value)
+{
+    return (options.omit_null_members && is_null_value(value)) ||
+           (options.omit_default_members && is_default_value(value, overload_rank<2>{}));
+}
+
 template <typename Writer, typename KeyType, typename ValueType>
 void insert_key_value_pair(Writer& writer, const KeyType& key, const ValueType& value)
 {
-    writer.Key(locksmith<typename Writer::Ch>::generate_key(key).c_str());
+    if (is_omitted_member(options_of(writer), value)) {
+        return;
+    }
+
+    insert_key(writer, key);
     serializer::to_json(writer, value);
 }
 
@@ -105,11 +470,62 @@ template <typename WriterType> void to_json(WriterType& writer, std::uint64_t da
     writer.Uint64(data);
 }
 
+template <typename, typename = void> struct has_float_member : std::false_type
+{
+};
+
+template <typename WriterType>
+struct has_float_member<
+    WriterType, future_std::void_t<decltype(std::declval<WriterType&>().Float(0.0f))>>
+    : std::true_type
+{
+};
+
+template <typename WriterType>
+void write_floating_point(WriterType& writer, float data, std::true_type)
+{
+    writer.Float(data);
+}
+
+template <typename WriterType, typename DataType>
+void write_floating_point(WriterType& writer, DataType data, std::false_type)
+{
+    writer.Double(static_cast<double>(data));
+}
+
 template <typename WriterType, typename DataType>
 auto to_json(WriterType& writer, DataType data)
     -> std::enable_if_t<std::is_floating_point<DataType>::value>
 {
-    writer.Double(data);
+    using writes_float = std::integral_constant<
+        bool, std::is_same<DataType, float>::value && has_float_member<WriterType>::value>;
+
+    write_floating_point(writer, data, writes_float{});
+}
+
+template <typename, typename = void> struct has_external_string : std::false_type
+{
+};
+
+template <typename WriterType>
+struct has_external_string<
+    WriterType, future_std::void_t<decltype(std::declval<WriterType&>().external_string(
+                    std::declval<const typename WriterType::Ch*>(),
+                    std::declval<rapidjson::SizeType>()))>>
+    : std::true_type
+{
+};
+
+template <typename WriterType>
+void write_stable_string(WriterType& writer, const stable_string& data, std::true_type)
+{
+    writer.external_string(data.data(), static_cast<rapidjson::SizeType>(data.size()));
+}
+
+template <typename WriterType>
+void write_stable_string(WriterType& writer, const stable_string& data, std::false_type)
+{
+    writer.String(data.data(), static_cast<rapidjson::SizeType>(data.size()));
 }
 
 template <typename WriterType, typename CharacterType, typename CharacterTraits, typename Allocator>
@@ -121,7 +537,7 @@ void to_json(
         "The character type to be serialized differs from the character type of the "
         "rapidjson::Writer object.");
 
-    writer.String(data.c_str());
+    writer.String(data.data(), static_cast<rapidjson::SizeType>(data.size()));
 }
 
 template <typename WriterType> void to_json(WriterType& writer, const char* data)
@@ -144,6 +560,372 @@ template <typename WriterType> void to_json(WriterType& writer, const wchar_t* d
     writer.String(data);
 }
 
+template <typename, typename = void> struct has_unescaped_string : std::false_type
+{
+};
+
+template <typename WriterType>
+struct has_unescaped_string<
+    WriterType, future_std::void_t<decltype(std::declval<WriterType&>().unescaped_string(
+                    std::declval<const char*>(), std::declval<rapidjson::SizeType>()))>>
+    : std::true_type
+{
+};
+
+template <typename WriterType>
+void write_trusted_ascii(WriterType& writer, const trusted_ascii& data, std::true_type)
+{
+    writer.unescaped_string(data.data(), static_cast<rapidjson::SizeType>(data.size()));
+}
+
+template <typename WriterType>
+void write_trusted_ascii(WriterType& writer, const trusted_ascii& data, std::false_type)
+{
+    writer.String(data.data(), static_cast<rapidjson::SizeType>(data.size()));
+}
+
+template <typename WriterType> void to_json(WriterType& writer, const trusted_ascii& data)
+{
+    static_assert(
+        std::is_same<typename WriterType::Ch, char>::value,
+        "Trusted ASCII strings can only be written by a narrow character writer.");
+
+    write_trusted_ascii(writer, data, has_unescaped_string<WriterType>{});
+}
+
+template <typename WriterType> void to_json(WriterType& writer, const stable_string& data)
+{
+    static_assert(
+        std::is_same<typename WriterType::Ch, char>::value,
+        "Stable strings can only be written by a narrow character writer.");
+
+    write_stable_string(writer, data, has_external_string<WriterType>{});
+}
+
+template <typename, typename = void> struct has_raw_value : std::false_type
+{
+};
+
+template <typename WriterType>
+struct has_raw_value<
+    WriterType, future_std::void_t<decltype(std::declval<WriterType&>().RawValue(
+                    std::declval<const char*>(), std::size_t{}, rapidjson::kObjectType))>>
+    : std::true_type
+{
+};
+
+template <typename, typename = void> struct has_set_indent : std::false_type
+{
+};
+
+template <typename WriterType>
+struct has_set_indent<
+    WriterType,
+    future_std::void_t<decltype(std::declval<WriterType&>().SetIndent(' ', 4u))>>
+    : std::true_type
+{
+};
+
+/**
+ * Writers whose `RawValue(...)` doesn't simply copy text into the output can declare a static
+ * `accepts_raw_json` member that is false, so that JSON is never spliced into them.
+ **/
+template <typename, typename = void> struct writer_accepts_raw_json : std::true_type
+{
+};
+
+template <typename WriterType>
+struct writer_accepts_raw_json<
+    WriterType, future_std::void_t<decltype(WriterType::accepts_raw_json)>>
+    : std::integral_constant<bool, WriterType::accepts_raw_json>
+{
+};
+
+/**
+ * Whether the writer can splice JSON that was written by a compact, narrow writer into its output.
+ **/
+template <typename WriterType>
+struct can_splice_raw_json
+    : std::integral_constant<
+          bool, std::is_same<typename WriterType::Ch, char>::value &&
+                    has_raw_value<WriterType>::value && !has_set_indent<WriterType>::value &&
+                    writer_accepts_raw_json<WriterType>::value>
+{
+};
+
+using shared_pointer_memo = json_utils::detail::shared_pointer_memo;
+
+template <typename, typename = void> struct has_shared_pointer_memo : std::false_type
+{
+};
+
+template <typename WriterType>
+struct has_shared_pointer_memo<
+    WriterType, future_std::void_t<decltype(std::declval<const WriterType&>().get_memo())>>
+    : std::true_type
+{
+};
+
+/**
+ * Whether the writer's output is retained by its stream, such that the JSON of a shared object can
+ * be replayed from where it was first written.
+ **/
+template <typename, typename = void> struct has_retained_output : std::false_type
+{
+};
+
+template <typename WriterType>
+struct has_retained_output<
+    WriterType, future_std::void_t<decltype(std::declval<WriterType&>().output_stream())>>
+    : std::is_same<
+          std::decay_t<decltype(std::declval<WriterType&>().output_stream())>,
+          string_output_stream<>>
+{
+};
+
+/**
+ * Locates the value that was written to the stream from the given offset onward, without the
+ * separator that a compact writer writes ahead of it.
+ **/
+inline shared_pointer_memo::entry
+locate_json(const string_output_stream<>& stream, std::size_t offset) noexcept
+{
+    const auto& json = stream.str();
+    if (offset < json.size() && (json[offset] == ',' || json[offset] == ':')) {
+        ++offset;
+    }
+
+    return { 0, &stream, offset, json.size() - offset, false, false, false };
+}
+
+/**
+ * Writes a value straight into the writer's stream, and locates its JSON there.
+ **/
+template <typename WriterType, typename FunctionType>
+shared_pointer_memo::entry write_recorded(
+    WriterType& writer, shared_pointer_memo& /*memo*/, FunctionType&& write, std::true_type)
+{
+    const auto& stream = writer.output_stream();
+    const auto offset = stream.size();
+
+    write(writer);
+
+    return locate_json(stream, offset);
+}
+
+/**
+ * Writes a value into the memo's arena, since the writer's stream doesn't retain its output, and
+ * then copies it into the writer.
+ **/
+template <typename WriterType, typename FunctionType>
+shared_pointer_memo::entry write_recorded(
+    WriterType& writer, shared_pointer_memo& memo, FunctionType&& write, std::false_type)
+{
+    auto& arena = memo.arena;
+    const auto offset = arena.size();
+
+    json_utils::writer<string_output_stream<>> arena_writer{ arena };
+    arena_writer.inherit_options(writer);
+
+    write(arena_writer);
+
+    const auto entry = locate_json(arena, offset);
+    writer.RawValue(arena.str().data() + entry.offset, entry.length, rapidjson::kObjectType);
+
+    return entry;
+}
+
+template <typename WriterType, typename FunctionType>
+shared_pointer_memo::entry
+write_recorded(WriterType& writer, shared_pointer_memo& memo, FunctionType&& write)
+{
+    return write_recorded(
+        writer, memo, std::forward<FunctionType>(write), has_retained_output<WriterType>{});
+}
+
+template <typename WriterType>
+void replay_json(WriterType& writer, const shared_pointer_memo::entry& entry, std::false_type)
+{
+    writer.RawValue(
+        entry.stream->str().data() + entry.offset, entry.length, rapidjson::kObjectType);
+}
+
+template <typename WriterType>
+void replay_json(WriterType& writer, const shared_pointer_memo::entry& entry, std::true_type)
+{
+    auto& stream = writer.output_stream();
+    if (entry.stream != &stream) {
+        replay_json(writer, entry, std::false_type{});
+        return;
+    }
+
+    // Only the separator is written through the writer, since copying from the stream into itself
+    // could reallocate its buffer mid-copy.
+    writer.RawValue("", 0, rapidjson::kObjectType);
+    stream.repeat(entry.offset, entry.length);
+}
+
+/**
+ * Writes the JSON of an object again, without serializing the object again.
+ **/
+template <typename WriterType>
+void replay_json(WriterType& writer, const shared_pointer_memo::entry& entry)
+{
+    replay_json(writer, entry, has_retained_output<WriterType>{});
+}
+
+template <typename WriterType, typename DataType>
+void memoize_pointee(
+    WriterType& writer, shared_pointer_memo& /*memo*/, const std::shared_ptr<DataType>& pointer,
+    std::false_type)
+{
+    to_json(writer, *pointer);
+}
+
+template <typename WriterType, typename DataType>
+void memoize_pointee(
+    WriterType& writer, shared_pointer_memo& memo, const std::shared_ptr<DataType>& pointer,
+    std::true_type)
+{
+    const auto key = shared_pointer_memo::key_of(*pointer);
+
+    const auto match = memo.entries.find(key);
+    if (match != memo.entries.end()) {
+        replay_json(writer, match->second);
+        return;
+    }
+
+    // An object that has no other owner can't be reached through another pointer.
+    if (pointer.use_count() <= 1) {
+        to_json(writer, *pointer);
+        return;
+    }
+
+    auto entry = write_recorded(writer, memo, [&](auto& target) { to_json(target, *pointer); });
+    entry.is_complete = true;
+
+    memo.entries.emplace(key, entry);
+}
+
+template <typename WriterType> void write_reference(WriterType& writer, std::uint64_t id)
+{
+    using Ch = typename WriterType::Ch;
+    static const Ch key[] = { '$', 'r', 'e', 'f' };
+
+    writer.StartObject();
+    writer.Key(key, 4);
+    writer.Uint64(id);
+    writer.EndObject();
+}
+
+template <typename WriterType, typename DataType>
+void rewrite_pointee(
+    WriterType& writer, const shared_pointer_memo::entry& /*entry*/, const DataType& pointee,
+    std::false_type)
+{
+    to_json(writer, pointee);
+}
+
+template <typename WriterType, typename DataType>
+void rewrite_pointee(
+    WriterType& writer, const shared_pointer_memo::entry& entry, const DataType& /*pointee*/,
+    std::true_type)
+{
+    replay_json(writer, entry);
+}
+
+template <typename WriterType, typename FunctionType>
+shared_pointer_memo::entry write_first_reference(
+    WriterType& writer, shared_pointer_memo& memo, FunctionType&& write, std::true_type)
+{
+    return write_recorded(writer, memo, std::forward<FunctionType>(write));
+}
+
+template <typename WriterType, typename FunctionType>
+shared_pointer_memo::entry write_first_reference(
+    WriterType& writer, shared_pointer_memo& /*memo*/, FunctionType&& write, std::false_type)
+{
+    write(writer);
+
+    return { 0, nullptr, 0, 0, false, false, false };
+}
+
+/**
+ * Writes the object in full, with a `"$id"` member, when it is first encountered, and refers to it
+ * by that identifier from then on. Since the object is registered before it is written, cycles
+ * also resolve to references. Objects that aren't written as JSON objects are replayed where the
+ * writer can splice JSON into its output, and serialized again otherwise.
+ *
+ * @throws std::invalid_argument if the object refers back to itself, but isn't written as a JSON
+ * object, such that it can't be given an identifier.
+ **/
+template <typename WriterType, typename DataType, typename CanSpliceType>
+void reference_pointee(
+    WriterType& writer, shared_pointer_memo& memo, const DataType& pointee,
+    CanSpliceType can_splice)
+{
+    const auto key = shared_pointer_memo::key_of(pointee);
+
+    const auto match = memo.entries.find(key);
+    if (match != memo.entries.end()) {
+        auto& entry = match->second;
+
+        if (entry.is_complete && !entry.is_identified) {
+            rewrite_pointee(writer, entry, pointee, can_splice);
+        } else {
+            entry.is_referenced = true;
+            write_reference(writer, entry.id);
+        }
+
+        return;
+    }
+
+    const auto id = ++memo.last_id;
+    memo.entries.emplace(key, shared_pointer_memo::entry{ id, nullptr, 0, 0, false, false, false });
+
+    bool is_identified = false;
+    const auto write = [&](auto& target) {
+        is_identified = target.write_identified(id, [&] { to_json(target, pointee); });
+    };
+
+    const auto location = write_first_reference(writer, memo, write, can_splice);
+
+    // Serializing the object may have added entries, and rehashed the table.
+    auto& entry = memo.entries.at(key);
+    entry.stream = location.stream;
+    entry.offset = location.offset;
+    entry.length = location.length;
+    entry.is_complete = true;
+    entry.is_identified = is_identified;
+
+    if (entry.is_referenced && !entry.is_identified) {
+        throw std::invalid_argument{ "Only objects that are written as JSON objects can be "
+                                     "referred to from within themselves." };
+    }
+}
+
+template <typename WriterType, typename DataType>
+void write_pointee(WriterType& writer, const std::shared_ptr<DataType>& pointer, std::false_type)
+{
+    to_json(writer, *pointer);
+}
+
+template <typename WriterType, typename DataType>
+void write_pointee(WriterType& writer, const std::shared_ptr<DataType>& pointer, std::true_type)
+{
+    const auto& memo = writer.get_memo();
+    if (memo == nullptr) {
+        to_json(writer, *pointer);
+        return;
+    }
+
+    if (writer.get_options().shared_pointers == shared_pointer_policy::reference) {
+        reference_pointee(writer, *memo, *pointer, can_splice_raw_json<WriterType>{});
+    } else {
+        memoize_pointee(writer, *memo, pointer, can_splice_raw_json<WriterType>{});
+    }
+}
+
 template <typename WriterType, typename DataType>
 void to_json(WriterType& writer, const std::shared_ptr<DataType>& pointer)
 {
@@ -152,7 +934,7 @@ void to_json(WriterType& writer, const std::shared_ptr<DataType>& pointer)
         return;
     }
 
-    to_json(writer, *pointer);
+    write_pointee(writer, pointer, has_shared_pointer_memo<WriterType>{});
 }
 
 template <typename WriterType, typename DataType>
@@ -169,13 +951,7 @@ void to_json(WriterType& writer, const std::unique_ptr<DataType>& pointer)
 template <typename WriterType, typename DataType>
 void to_json(WriterType& writer, const std::weak_ptr<DataType>& weakPointer)
 {
-    const auto strongPointer = weakPointer.lock();
-    if (strongPointer == nullptr) {
-        writer.Null();
-        return;
-    }
-
-    to_json(writer, *strongPointer);
+    to_json(writer, weakPointer.lock());
 }
 
 template <typename WriterType, typename ContainerType>
@@ -210,12 +986,97 @@ void to_json(WriterType& writer, const std::pair<FirstType, SecondType>& pair)
     insert_key_value_pair(writer, pair.first, pair.second);
 }
 
+/**
+ * Visits every element of a range, which is delimited by an iterator and a sentinel that need not
+ * be of the same type.
+ **/
+template <typename RangeType, typename CallbackType>
+void for_each_element(RangeType& range, CallbackType&& callback)
+{
+    using std::begin;
+    using std::end;
+
+    const auto last = end(range);
+    for (auto iterator = begin(range); iterator != last; ++iterator) {
+        callback(*iterator);
+    }
+}
+
+template <typename WriterType, typename RangeType>
+void to_json(WriterType& writer, const array_range<RangeType>& data)
+{
+    writer.StartArray();
+
+    for_each_element(data.range(), [&](const auto& element) { to_json(writer, element); });
+
+    writer.EndArray();
+}
+
+template <
+    typename WriterType, typename RangeType, typename KeyProjectionType,
+    typename ValueProjectionType>
+void to_json(
+    WriterType& writer,
+    const object_range<RangeType, KeyProjectionType, ValueProjectionType>& data)
+{
+    writer.StartObject();
+
+    for_each_element(data.range(), [&](const auto& element) {
+        insert_key_value_pair(
+            writer, data.key_projection()(element), data.value_projection()(element));
+    });
+
+    writer.EndObject();
+}
+
+template <typename WriterType> struct array_emitter
+{
+    template <typename DataType> void operator()(const DataType& data) const
+    {
+        to_json(writer, data);
+    }
+
+    WriterType& writer;
+};
+
+template <typename WriterType> struct object_emitter
+{
+    template <typename KeyType, typename ValueType>
+    void operator()(const KeyType& key, const ValueType& value) const
+    {
+        insert_key_value_pair(writer, key, value);
+    }
+
+    WriterType& writer;
+};
+
+template <typename WriterType, typename GeneratorType>
+void to_json(WriterType& writer, const generated_array<GeneratorType>& data)
+{
+    writer.StartArray();
+    data.generator()(array_emitter<WriterType>{ writer });
+    writer.EndArray();
+}
+
+template <typename WriterType, typename GeneratorType>
+void to_json(WriterType& writer, const generated_object<GeneratorType>& data)
+{
+    writer.StartObject();
+    data.generator()(object_emitter<WriterType>{ writer });
+    writer.EndObject();
+}
+
 #if __cplusplus >= 201703L // C++17
 
 template <typename WriterType, typename CharacterType, typename CharacterTraits>
 void to_json(WriterType& writer, const std::basic_string_view<CharacterType, CharacterTraits>& view)
 {
-    writer.String(view.data());
+    static_assert(
+        std::is_same<CharacterType, typename WriterType::Ch>::value,
+        "The character type to be serialized differs from the character type of the "
+        "rapidjson::Writer object.");
+
+    writer.String(view.data(), static_cast<rapidjson::SizeType>(view.size()));
 }
 
 template <typename WriterType, typename DataType>
@@ -0,0 +1,84 @@
+#pragma once
+
+#if __cplusplus >= 201703L // C++17
+
+#include <cstddef>
+#include <string_view>
+
+#include "json_output_streams.h"
+#include "json_serializer.h"
+#include "json_writer.h"
+
+namespace json_utils
+{
+namespace detail
+{
+/**
+ * Owns an output buffer and a writer that are reused from one serialization to the next. Resetting
+ * the session discards the previous output, but retains the capacity of both the buffer and the
+ * writer's internal level stack, so that once the session has warmed up, serializing messages of a
+ * similar size no longer requires any heap allocation.
+ *
+ * @note The view returned by `serialize(...)` is only valid until the next call to `serialize(...)`
+ * or `reset()`.
+ **/
+template <
+    template <typename, typename, typename, typename, unsigned> class WriterTemplate,
+    typename InputEncodingType, typename OutputEncodingType>
+class basic_serializer_session
+{
+    using stream_type = string_output_stream<OutputEncodingType>;
+    using writer_type = WriterTemplate<
+        stream_type, InputEncodingType, OutputEncodingType, rapidjson::CrtAllocator,
+        rapidjson::kWriteDefaultFlags>;
+
+  public:
+    using char_type = typename OutputEncodingType::Ch;
+    using view_type = std::basic_string_view<char_type>;
+
+    basic_serializer_session() = default;
+
+    explicit basic_serializer_session(std::size_t capacity) : m_stream{ capacity }
+    {
+    }
+
+    basic_serializer_session(const basic_serializer_session&) = delete;
+    basic_serializer_session& operator=(const basic_serializer_session&) = delete;
+
+    template <typename DataType> view_type serialize(const DataType& data)
+    {
+        reset();
+        serializer::to_json(m_writer, data);
+
+        return view();
+    }
+
+    view_type view() const noexcept
+    {
+        return m_stream.str();
+    }
+
+    void reset() noexcept
+    {
+        m_stream.clear();
+        m_writer.Reset(m_stream);
+    }
+
+  private:
+    stream_type m_stream;
+    writer_type m_writer{ m_stream };
+};
+} // namespace detail
+
+template <
+    typename InputEncodingType = rapidjson::UTF8<>, typename OutputEncodingType = rapidjson::UTF8<>>
+using serializer_session =
+    detail::basic_serializer_session<json_utils::writer, InputEncodingType, OutputEncodingType>;
+
+template <
+    typename InputEncodingType = rapidjson::UTF8<>, typename OutputEncodingType = rapidjson::UTF8<>>
+using pretty_serializer_session = detail::basic_serializer_session<
+    json_utils::pretty_writer, InputEncodingType, OutputEncodingType>;
+} // namespace json_utils
+
+#endif
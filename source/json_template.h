@@ -0,0 +1,301 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <rapidjson/error/en.h>
+#include <rapidjson/reader.h>
+
+#include "json_output_streams.h"
+#include "json_serialization_options.h"
+#include "json_serializer.h"
+#include "json_writer.h"
+
+namespace json_utils
+{
+namespace detail
+{
+/**
+ * A rapidjson SAX handler that rewrites a template's skeleton in compact form, and that records
+ * the offset in the output at which each placeholder's value belongs.
+ **/
+class template_compiler
+{
+  public:
+    using Ch = char;
+
+    explicit template_compiler(std::vector<bool> placeholder_nulls)
+        : m_placeholder_nulls{ std::move(placeholder_nulls) }
+    {
+    }
+
+    bool Null()
+    {
+        if (!m_placeholder_nulls[m_null_index++]) {
+            return m_writer.Null();
+        }
+
+        // Writing an empty raw value emits the separator that precedes the value, but nothing else.
+        m_writer.RawValue("", 0, rapidjson::kNullType);
+        m_placeholder_offsets.push_back(m_stream.size());
+
+        return true;
+    }
+
+    bool Bool(bool value)
+    {
+        return m_writer.Bool(value);
+    }
+
+    bool Int(int value)
+    {
+        return m_writer.Int(value);
+    }
+
+    bool Uint(unsigned value)
+    {
+        return m_writer.Uint(value);
+    }
+
+    bool Int64(std::int64_t value)
+    {
+        return m_writer.Int64(value);
+    }
+
+    bool Uint64(std::uint64_t value)
+    {
+        return m_writer.Uint64(value);
+    }
+
+    bool Double(double value)
+    {
+        return m_writer.Double(value);
+    }
+
+    bool RawNumber(const Ch* value, rapidjson::SizeType length, bool /*copy*/)
+    {
+        return m_writer.RawValue(value, length, rapidjson::kNumberType);
+    }
+
+    bool String(const Ch* value, rapidjson::SizeType length, bool /*copy*/)
+    {
+        return m_writer.String(value, length);
+    }
+
+    bool StartObject()
+    {
+        return m_writer.StartObject();
+    }
+
+    bool Key(const Ch* value, rapidjson::SizeType length, bool /*copy*/)
+    {
+        return m_writer.Key(value, length);
+    }
+
+    bool EndObject(rapidjson::SizeType member_count)
+    {
+        return m_writer.EndObject(member_count);
+    }
+
+    bool StartArray()
+    {
+        return m_writer.StartArray();
+    }
+
+    bool EndArray(rapidjson::SizeType element_count)
+    {
+        return m_writer.EndArray(element_count);
+    }
+
+    const std::string& text() const noexcept
+    {
+        return m_stream.str();
+    }
+
+    const std::vector<std::size_t>& placeholder_offsets() const noexcept
+    {
+        return m_placeholder_offsets;
+    }
+
+  private:
+    std::vector<bool> m_placeholder_nulls;
+    std::size_t m_null_index = 0;
+
+    string_output_stream<> m_stream;
+    json_utils::writer<string_output_stream<>> m_writer{ m_stream };
+
+    std::vector<std::size_t> m_placeholder_offsets;
+};
+
+/**
+ * Replaces every placeholder (a `?` outside of a string) with a `null`, so that the skeleton can be
+ * validated by the regular parser.
+ *
+ * @returns For every `null` in the resultant text, in order, whether it stands for a placeholder.
+ **/
+inline std::vector<bool> substitute_placeholders(const std::string& skeleton, std::string& text)
+{
+    std::vector<bool> placeholder_nulls;
+    text.reserve(skeleton.size());
+
+    bool is_in_string = false;
+
+    for (std::size_t index = 0; index < skeleton.size(); ++index) {
+        const char character = skeleton[index];
+
+        if (is_in_string) {
+            text.push_back(character);
+
+            if (character == '\\' && index + 1 < skeleton.size()) {
+                text.push_back(skeleton[++index]);
+            } else if (character == '"') {
+                is_in_string = false;
+            }
+        } else if (character == '?') {
+            text.append("null");
+            placeholder_nulls.push_back(true);
+        } else if (skeleton.compare(index, 4, "null") == 0) {
+            text.append("null");
+            placeholder_nulls.push_back(false);
+            index += 3;
+        } else {
+            text.push_back(character);
+            is_in_string = character == '"';
+        }
+    }
+
+    return placeholder_nulls;
+}
+} // namespace detail
+
+/**
+ * A JSON document of a fixed shape, which is compiled once from a skeleton in which every value
+ * that changes is replaced by a `?` placeholder, for instance:
+ *
+ * @code
+ * const json_template<std::uint64_t, std::string> heartbeat{
+ *     R"({"type": "heartbeat", "sequence": ?, "node": ?})" };
+ *
+ * const auto json = heartbeat.render(sequence, node_name);
+ * @endcode
+ *
+ * The skeleton is validated, compacted, and split into static runs (with all keys and literals
+ * already escaped) when the template is constructed. Rendering then amounts to copying those runs,
+ * interleaved with the values, which are formatted by their regular `to_json(...)` overloads, in
+ * the order in which the placeholders appear.
+ *
+ * @note Placeholders can only stand in for values; not for keys, or parts of strings.
+ **/
+template <typename... ValueTypes> class json_template
+{
+    static constexpr std::size_t placeholder_count = sizeof...(ValueTypes);
+
+  public:
+    /**
+     * @throws std::invalid_argument if the skeleton isn't valid JSON, or if the number of
+     * placeholders differs from the number of value types.
+     **/
+    explicit json_template(const std::string& skeleton, const serialization_options& options = {})
+        : m_options{ options }
+    {
+        std::string text;
+        detail::template_compiler compiler{ detail::substitute_placeholders(skeleton, text) };
+
+        rapidjson::StringStream stream{ text.c_str() };
+        rapidjson::Reader reader;
+
+        constexpr auto flags = rapidjson::kParseNumbersAsStringsFlag;
+
+        if (!reader.Parse<flags>(stream, compiler)) {
+            const auto* const error = rapidjson::GetParseError_En(reader.GetParseErrorCode());
+            const auto offset = std::to_string(reader.GetErrorOffset());
+
+            throw std::invalid_argument{ std::string{ "Invalid JSON template: " } + error +
+                                         " at offset " + offset + "." };
+        }
+
+        const auto& offsets = compiler.placeholder_offsets();
+
+        if (offsets.size() != placeholder_count) {
+            throw std::invalid_argument{ "The JSON template has " + std::to_string(offsets.size()) +
+                                         " placeholders, but " +
+                                         std::to_string(placeholder_count) + " value types." };
+        }
+
+        m_text = compiler.text();
+
+        std::copy(std::begin(offsets), std::end(offsets), std::begin(m_run_ends));
+        m_run_ends[placeholder_count] = m_text.size();
+    }
+
+    /**
+     * @returns The rendered document.
+     **/
+    std::string render(const ValueTypes&... values) const
+    {
+        string_output_stream<> stream{ m_text.size() + 16 * placeholder_count };
+        render_to(stream, values...);
+
+        return stream.release();
+    }
+
+    /**
+     * Writes the rendered document to the output stream, without flushing it.
+     **/
+    template <typename OutputStreamType>
+    void render_to(OutputStreamType& stream, const ValueTypes&... values) const
+    {
+        static_assert(
+            std::is_same<typename OutputStreamType::Ch, char>::value,
+            "JSON templates can only be rendered to a narrow character stream.");
+
+        detail::deferred_flush_stream<OutputStreamType> output{ stream };
+
+        json_utils::writer<decltype(output)> writer{ output };
+        writer.set_options(m_options);
+
+        write_parts(output, writer, std::index_sequence_for<ValueTypes...>{}, values...);
+    }
+
+  private:
+    template <typename StreamType> void write_run(StreamType& stream, std::size_t index) const
+    {
+        const auto begin = index == 0 ? 0 : m_run_ends[index - 1];
+        detail::put_range(stream, m_text.data() + begin, m_run_ends[index] - begin);
+    }
+
+    template <typename StreamType, typename WriterType, typename DataType>
+    void write_placeholder(
+        StreamType& stream, WriterType& writer, std::size_t index, const DataType& value) const
+    {
+        write_run(stream, index);
+
+        writer.Reset(stream);
+        serializer::to_json(writer, value);
+    }
+
+    template <typename StreamType, typename WriterType, std::size_t... Indices>
+    void write_parts(
+        StreamType& stream, WriterType& writer, std::index_sequence<Indices...>,
+        const ValueTypes&... values) const
+    {
+        static_cast<void>(writer);
+
+        using expand = int[];
+        static_cast<void>(expand{ 0, (write_placeholder(stream, writer, Indices, values), 0)... });
+
+        write_run(stream, placeholder_count);
+    }
+
+    std::string m_text;
+    std::array<std::size_t, placeholder_count + 1> m_run_ends;
+    serialization_options m_options;
+};
+} // namespace json_utils
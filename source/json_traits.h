@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+#include <iterator>
 #include <memory>
 #include <string>
 #include <type_traits>
@@ -124,6 +126,69 @@ template <typename DataType> struct treat_as_array_or_object_sink
     static constexpr bool value = !treat_as_value_sink<DataType>::value;
 };
 
+/**
+ * @note Integers can be used as the keys of JSON objects, but `bool` and the character types can't,
+ * since the keys that those would produce are rarely the intended ones.
+ **/
+template <typename KeyType>
+struct is_integer_key
+    : std::integral_constant<
+          bool, std::is_integral<KeyType>::value && !std::is_same<KeyType, bool>::value &&
+                    !std::is_same<KeyType, char>::value &&
+                    !std::is_same<KeyType, wchar_t>::value &&
+                    !std::is_same<KeyType, char16_t>::value &&
+                    !std::is_same<KeyType, char32_t>::value>
+{
+};
+
+/**
+ * The types that `to_json(...)` writes as plain JSON values, without consulting any customization
+ * points.
+ **/
+template <typename DataType>
+struct is_direct_value
+    : std::integral_constant<
+          bool, std::is_same<DataType, bool>::value ||
+                    std::is_same<DataType, std::int32_t>::value ||
+                    std::is_same<DataType, std::uint32_t>::value ||
+                    std::is_same<DataType, std::int64_t>::value ||
+                    std::is_same<DataType, std::uint64_t>::value ||
+                    std::is_same<DataType, float>::value || std::is_same<DataType, double>::value ||
+                    std::is_same<DataType, std::string>::value>
+{
+};
+
+template <typename ContainerType>
+using element_type_t = std::decay_t<decltype(*std::begin(std::declval<const ContainerType&>()))>;
+
+/**
+ * @note Detects types whose entire structure is known at compile time, meaning that they consist of
+ * nothing but arrays, objects with `std::string` keys, and plain values, no matter how deeply they
+ * are nested.
+ **/
+template <typename DataType, typename = void>
+struct is_directly_serializable : is_direct_value<DataType>
+{
+};
+
+template <typename DataType>
+struct is_directly_serializable<
+    DataType, std::enable_if_t<treat_as_array_sink<DataType>::value>>
+    : is_directly_serializable<element_type_t<DataType>>
+{
+};
+
+template <typename DataType>
+struct is_directly_serializable<
+    DataType, std::enable_if_t<treat_as_object_sink<DataType>::value>>
+    : std::integral_constant<
+          bool, std::is_same<
+                    std::remove_const_t<typename DataType::value_type::first_type>,
+                    std::string>::value &&
+                    is_directly_serializable<typename DataType::value_type::second_type>::value>
+{
+};
+
 template <typename, typename = void> struct is_shared_ptr : std::false_type
 {
 };
@@ -176,6 +241,11 @@ template <typename ContainerType>
 constexpr bool treat_as_array_or_object_sink_v =
     treat_as_array_or_object_sink<ContainerType>::value;
 
+template <typename KeyType> constexpr bool is_integer_key_v = is_integer_key<KeyType>::value;
+
+template <typename Type>
+constexpr bool is_directly_serializable_v = is_directly_serializable<Type>::value;
+
 template <typename Type> constexpr bool is_shared_ptr_v = is_shared_ptr<Type>::value;
 
 template <typename Type> constexpr bool is_unique_ptr_v = is_unique_ptr<Type>::value;
@@ -6,16 +6,69 @@
 #include <fstream>
 
 #include <rapidjson/istreamwrapper.h>
-#include <rapidjson/ostreamwrapper.h>
 
 #endif
 
+#include "json_cbor.h"
+#include "json_columnar.h"
+#include "json_compressed_streams.h"
+#include "json_direct_serializer.h"
 #include "json_dom_deserializer.h"
+#include "json_fragment_cache.h"
+#include "json_hash_writer.h"
+#include "json_lines_writer.h"
+#include "json_mmap_output_stream.h"
+#include "json_msgpack.h"
+#include "json_output_streams.h"
+#include "json_parallel_serializer.h"
+#include "json_ranges.h"
+#include "json_raw.h"
+#include "json_resumable_serializer.h"
 #include "json_sax_deserializer.h"
+#include "json_serialization_options.h"
 #include "json_serializer.h"
+#include "json_serializer_session.h"
+#include "json_template.h"
+#include "json_writer.h"
 
 namespace json_utils
 {
+/**
+ * Tag type that requests that the serialization be measured before it is written out, so that the
+ * resultant string is allocated exactly once. This costs an extra traversal of the data, but avoids
+ * the repeated reallocation (and the transient memory overhead) of geometric growth, which pays off
+ * for large outputs.
+ *
+ * @note Since the data is serialized twice, generators (see `generate_array(...)`) are called twice
+ * as well, and must produce the same output both times.
+ **/
+struct exact_size_tag
+{
+};
+
+constexpr exact_size_tag exact_size{};
+
+/**
+ * Tag type that requests that a file be written through a shared memory mapping, rather than
+ * through `write(2)` calls. Where the file can't be mapped (e.g., on filesystems that don't support
+ * it, or on platforms other than POSIX), the regular buffered output is used instead.
+ **/
+struct mmap_output_tag
+{
+};
+
+constexpr mmap_output_tag mmap_output{};
+
+/**
+ * Tag type that requests that a file be compressed as it's written, or decompressed as it's read.
+ * See `compressed_output_stream` and `compressed_input_stream`.
+ **/
+struct compressed_tag
+{
+};
+
+constexpr compressed_tag compressed{};
+
 namespace detail
 {
 template <
@@ -39,6 +92,35 @@ ContainerType deserialize(StreamType& stream)
 
     return container;
 }
+
+template <typename InputEncodingType, typename OutputEncodingType, typename DataType>
+std::basic_string<typename OutputEncodingType::Ch>
+serialize_to_json(const DataType& data, const serialization_options& options, std::false_type)
+{
+    string_output_stream<OutputEncodingType> stream;
+    json_utils::writer<decltype(stream), InputEncodingType, OutputEncodingType> writer{ stream };
+    writer.set_options(options);
+
+    serializer::to_json(writer, data);
+
+    return stream.release();
+}
+
+/**
+ * @note Selected for data whose structure is known at compile time, which is written without going
+ * through `rapidjson::Writer<...>`, but with the same result.
+ **/
+template <typename InputEncodingType, typename OutputEncodingType, typename DataType>
+std::string
+serialize_to_json(const DataType& data, const serialization_options& options, std::true_type)
+{
+    string_output_stream<> stream;
+
+    direct_serializer<string_output_stream<>> serializer{ stream, options };
+    serializer.write(data);
+
+    return stream.release();
+}
 } // namespace detail
 
 template <
@@ -47,12 +129,43 @@ template <
 JSON_UTILS_NODISCARD std::basic_string<typename OutputEncodingType::Ch>
 serialize_to_json(const DataType& data)
 {
-    rapidjson::GenericStringBuffer<OutputEncodingType> buffer;
-    rapidjson::Writer<decltype(buffer), InputEncodingType, OutputEncodingType> writer{ buffer };
+    return serialize_to_json<InputEncodingType, OutputEncodingType>(data, serialization_options{});
+}
+
+template <
+    typename InputEncodingType = rapidjson::UTF8<>, typename OutputEncodingType = rapidjson::UTF8<>,
+    typename DataType>
+JSON_UTILS_NODISCARD std::basic_string<typename OutputEncodingType::Ch>
+serialize_to_json(const DataType& data, exact_size_tag)
+{
+    counting_output_stream<OutputEncodingType> counter;
+    json_utils::writer<decltype(counter), InputEncodingType, OutputEncodingType> counting_writer{
+        counter
+    };
+
+    serializer::to_json(counting_writer, data);
+
+    string_output_stream<OutputEncodingType> stream{ counter.size() };
+    json_utils::writer<decltype(stream), InputEncodingType, OutputEncodingType> writer{ stream };
 
     serializer::to_json(writer, data);
 
-    return buffer.GetString();
+    return stream.release();
+}
+
+template <
+    typename InputEncodingType = rapidjson::UTF8<>, typename OutputEncodingType = rapidjson::UTF8<>,
+    typename DataType>
+JSON_UTILS_NODISCARD std::basic_string<typename OutputEncodingType::Ch>
+serialize_to_json(const DataType& data, const serialization_options& options)
+{
+    using is_direct = std::integral_constant<
+        bool, traits::is_directly_serializable_v<DataType> &&
+                  std::is_same<InputEncodingType, rapidjson::UTF8<>>::value &&
+                  std::is_same<OutputEncodingType, rapidjson::UTF8<>>::value>;
+
+    return detail::serialize_to_json<InputEncodingType, OutputEncodingType>(
+        data, options, is_direct{});
 }
 
 template <
@@ -61,14 +174,145 @@ template <
 JSON_UTILS_NODISCARD std::basic_string<typename OutputEncodingType::Ch>
 serialize_to_pretty_json(const DataType& data)
 {
-    rapidjson::GenericStringBuffer<OutputEncodingType> buffer;
-    rapidjson::PrettyWriter<decltype(buffer), InputEncodingType, OutputEncodingType> writer{
-        buffer
+    string_output_stream<OutputEncodingType> stream;
+    json_utils::pretty_writer<decltype(stream), InputEncodingType, OutputEncodingType> writer{
+        stream
+    };
+
+    serializer::to_json(writer, data);
+
+    return stream.release();
+}
+
+template <
+    typename InputEncodingType = rapidjson::UTF8<>, typename OutputEncodingType = rapidjson::UTF8<>,
+    typename DataType>
+JSON_UTILS_NODISCARD std::basic_string<typename OutputEncodingType::Ch>
+serialize_to_pretty_json(const DataType& data, exact_size_tag)
+{
+    counting_output_stream<OutputEncodingType> counter;
+    json_utils::pretty_writer<decltype(counter), InputEncodingType, OutputEncodingType>
+        counting_writer{ counter };
+
+    serializer::to_json(counting_writer, data);
+
+    string_output_stream<OutputEncodingType> stream{ counter.size() };
+    json_utils::pretty_writer<decltype(stream), InputEncodingType, OutputEncodingType> writer{
+        stream
+    };
+
+    serializer::to_json(writer, data);
+
+    return stream.release();
+}
+
+template <
+    typename InputEncodingType = rapidjson::UTF8<>, typename OutputEncodingType = rapidjson::UTF8<>,
+    typename DataType>
+JSON_UTILS_NODISCARD std::basic_string<typename OutputEncodingType::Ch>
+serialize_to_pretty_json(const DataType& data, const serialization_options& options)
+{
+    string_output_stream<OutputEncodingType> stream;
+    json_utils::pretty_writer<decltype(stream), InputEncodingType, OutputEncodingType> writer{
+        stream
     };
+    writer.set_options(options);
+
+    serializer::to_json(writer, data);
+
+    return stream.release();
+}
+
+/**
+ * Serializes the data in fixed-size chunks, handing each chunk to the callback as soon as it fills
+ * up, so that at no point does the entire document need to be held in memory.
+ *
+ * @param callback              Invoked as `callback(const Ch* data, std::size_t size)` for every
+ *                              chunk. Every chunk is `chunk_size` characters long, except for the
+ *                              last one, which may be shorter.
+ **/
+template <
+    typename InputEncodingType = rapidjson::UTF8<>, typename OutputEncodingType = rapidjson::UTF8<>,
+    typename DataType, typename CallbackType>
+void serialize_to_json_chunked(
+    const DataType& data, CallbackType&& callback,
+    std::size_t chunk_size = chunked_output_stream<CallbackType&>::default_chunk_size)
+{
+    chunked_output_stream<CallbackType&, OutputEncodingType> stream{ callback, chunk_size };
+    json_utils::writer<decltype(stream), InputEncodingType, OutputEncodingType> writer{ stream };
+
+    serializer::to_json(writer, data);
+
+    stream.Flush();
+}
+
+template <
+    typename InputEncodingType = rapidjson::UTF8<>, typename OutputEncodingType = rapidjson::UTF8<>,
+    typename DataType, typename CallbackType>
+void serialize_to_pretty_json_chunked(
+    const DataType& data, CallbackType&& callback,
+    std::size_t chunk_size = chunked_output_stream<CallbackType&>::default_chunk_size)
+{
+    chunked_output_stream<CallbackType&, OutputEncodingType> stream{ callback, chunk_size };
+    json_utils::pretty_writer<decltype(stream), InputEncodingType, OutputEncodingType> writer{
+        stream
+    };
+
+    serializer::to_json(writer, data);
+
+    stream.Flush();
+}
+
+/**
+ * Serializes the data into a list of segments, suitable for scatter-gather I/O, in which long
+ * strings that are wrapped in a `stable_string` are referenced in place, rather than copied.
+ *
+ * @note Those strings must outlive any use of the segments; see `segment_output_stream`.
+ **/
+template <typename DataType>
+void serialize_to_segments(const DataType& data, segment_output_stream& stream)
+{
+    json_utils::writer<segment_output_stream> writer{ stream };
+    serializer::to_json(writer, data);
+}
+
+/**
+ * Serializes the data into a list of segments, using the pretty writer.
+ **/
+template <typename DataType>
+void serialize_to_pretty_segments(const DataType& data, segment_output_stream& stream)
+{
+    json_utils::pretty_writer<segment_output_stream> writer{ stream };
+    serializer::to_json(writer, data);
+}
+
+/**
+ * Serializes the data to MessagePack, using the same `to_json(...)` overloads as
+ * `serialize_to_json(...)`.
+ **/
+template <typename DataType>
+JSON_UTILS_NODISCARD std::vector<std::uint8_t> serialize_to_msgpack(const DataType& data)
+{
+    std::vector<std::uint8_t> output;
+    msgpack_writer writer{ output };
+
+    serializer::to_json(writer, data);
+
+    return output;
+}
 
+/**
+ * Computes a 64-bit content hash of the data, as would be serialized by `serialize_to_json(...)`,
+ * without producing the JSON text. This makes for a cheap cache key, or change detector.
+ **/
+template <typename DataType>
+JSON_UTILS_NODISCARD std::uint64_t
+content_hash(const DataType& data, const hash_options& options = {})
+{
+    hash_writer writer{ options };
     serializer::to_json(writer, data);
 
-    return buffer.GetString();
+    return writer.digest();
 }
 
 template <
@@ -107,32 +351,146 @@ JSON_UTILS_NODISCARD ContainerType deserialize_via_dom(const std::wstring& json)
 
 #if __cplusplus >= 201703L
 
+namespace detail
+{
+template <
+    template <typename, typename, typename, typename, unsigned> class WriterTemplate,
+    typename InputEncodingType, typename OutputEncodingType, typename StreamType, typename DataType>
+void serialize_to_file_stream(const DataType& data, StreamType& stream)
+{
+    static_assert(
+        sizeof(typename OutputEncodingType::Ch) == 1,
+        "Files can only be written using a narrow character encoding.");
+
+    WriterTemplate<
+        StreamType, InputEncodingType, OutputEncodingType, rapidjson::CrtAllocator,
+        rapidjson::kWriteDefaultFlags>
+        writer{ stream };
+
+    serializer::to_json(writer, data);
+
+    stream.close();
+}
+
+template <
+    template <typename, typename, typename, typename, unsigned> class WriterTemplate,
+    typename InputEncodingType, typename OutputEncodingType, typename DataType>
+void serialize_to_mapped_file(
+    const DataType& data, const std::filesystem::path& path, const file_write_options& options)
+{
+#ifdef JSON_UTILS_MEMORY_MAPPED_FILES
+    std::unique_ptr<mmap_output_stream> mapped_stream;
+
+    try {
+        mapped_stream = std::make_unique<mmap_output_stream>(path, options);
+    } catch (const std::system_error& error) {
+        if (!is_mapping_unsupported(error.code().value())) {
+            throw;
+        }
+    }
+
+    if (mapped_stream != nullptr) {
+        serialize_to_file_stream<WriterTemplate, InputEncodingType, OutputEncodingType>(
+            data, *mapped_stream);
+
+        return;
+    }
+#endif
+
+    file_output_stream stream{ path, options };
+    serialize_to_file_stream<WriterTemplate, InputEncodingType, OutputEncodingType>(data, stream);
+}
+} // namespace detail
+
+/**
+ * Serializes the data directly to a file, through a large buffer that is written out with as few
+ * system calls as possible. Use the `file_write_options` to request that the data be synced to
+ * disk, or that the target file be replaced atomically.
+ *
+ * @throws std::system_error if the file can't be opened, written, synced, or replaced.
+ **/
 template <
     typename InputEncodingType = rapidjson::UTF8<>, typename OutputEncodingType = rapidjson::UTF8<>,
     typename DataType>
-void serialize_to_json(const DataType& data, const std::filesystem::path& path)
+void serialize_to_json(
+    const DataType& data, const std::filesystem::path& path,
+    const file_write_options& options = {})
 {
-    std::ofstream file_stream{ path };
-    rapidjson::OStreamWrapper stream_wrapper{ file_stream };
-    rapidjson::Writer<decltype(stream_wrapper), InputEncodingType, OutputEncodingType> writer{
-        stream_wrapper
-    };
+    file_output_stream stream{ path, options };
+    detail::serialize_to_file_stream<json_utils::writer, InputEncodingType, OutputEncodingType>(
+        data, stream);
+}
 
-    serializer::to_json(writer, data);
+template <
+    typename InputEncodingType = rapidjson::UTF8<>, typename OutputEncodingType = rapidjson::UTF8<>,
+    typename DataType>
+void serialize_to_pretty_json(
+    const DataType& data, const std::filesystem::path& path,
+    const file_write_options& options = {})
+{
+    file_output_stream stream{ path, options };
+    detail::serialize_to_file_stream<
+        json_utils::pretty_writer, InputEncodingType, OutputEncodingType>(data, stream);
 }
 
+/**
+ * Serializes the data directly into a memory mapping of the file, which avoids copying the output
+ * through a user-space buffer. This pays off for very large outputs.
+ *
+ * @throws std::system_error if the file can't be opened, written, synced, or replaced.
+ **/
 template <
     typename InputEncodingType = rapidjson::UTF8<>, typename OutputEncodingType = rapidjson::UTF8<>,
     typename DataType>
-void serialize_to_pretty_json(const DataType& data, const std::filesystem::path& path)
+void serialize_to_json(
+    const DataType& data, const std::filesystem::path& path, mmap_output_tag,
+    const file_write_options& options = {})
 {
-    std::ofstream file_stream{ path };
-    rapidjson::OStreamWrapper stream_wrapper{ file_stream };
-    rapidjson::PrettyWriter<decltype(stream_wrapper), InputEncodingType, OutputEncodingType> writer{
-        stream_wrapper
-    };
+    detail::serialize_to_mapped_file<json_utils::writer, InputEncodingType, OutputEncodingType>(
+        data, path, options);
+}
 
-    serializer::to_json(writer, data);
+template <
+    typename InputEncodingType = rapidjson::UTF8<>, typename OutputEncodingType = rapidjson::UTF8<>,
+    typename DataType>
+void serialize_to_pretty_json(
+    const DataType& data, const std::filesystem::path& path, mmap_output_tag,
+    const file_write_options& options = {})
+{
+    detail::serialize_to_mapped_file<
+        json_utils::pretty_writer, InputEncodingType, OutputEncodingType>(data, path, options);
+}
+
+/**
+ * Serializes the data to a file that's compressed on the fly. Unless a codec is specified, it's
+ * chosen based on the file extension (`.gz` or `.zst`).
+ *
+ * @throws std::system_error if the file can't be opened or written, std::invalid_argument if the
+ * codec can't be determined from the extension, and std::runtime_error if the codec isn't
+ * supported. The file is left untouched if either of the latter two is thrown.
+ **/
+template <
+    typename InputEncodingType = rapidjson::UTF8<>, typename OutputEncodingType = rapidjson::UTF8<>,
+    typename DataType>
+void serialize_to_json(
+    const DataType& data, const std::filesystem::path& path, compressed_tag,
+    const compression_options& options = {})
+{
+    compressed_output_stream stream{ path, options };
+    detail::serialize_to_file_stream<json_utils::writer, InputEncodingType, OutputEncodingType>(
+        data, stream);
+}
+
+template <
+    typename InputEncodingType = rapidjson::UTF8<>, typename OutputEncodingType = rapidjson::UTF8<>,
+    typename DataType>
+void serialize_to_pretty_json(
+    const DataType& data, const std::filesystem::path& path, compressed_tag,
+    const compression_options& options = {})
+{
+    compressed_output_stream stream{ path, options };
+    detail::serialize_to_file_stream<
+        json_utils::pretty_writer, InputEncodingType, OutputEncodingType>(data, stream);
 }
 
 template <
@@ -146,6 +504,19 @@ JSON_UTILS_NODISCARD ContainerType deserialize_via_dom(const std::filesystem::pa
     return detail::deserialize<ContainerType, EncodingType, ParseFlags>(stream_wrapper);
 }
 
+/**
+ * Deserializes a file that may be compressed (as determined by its magic bytes), decompressing it
+ * on a helper thread while it's being parsed.
+ **/
+template <
+    typename ContainerType, unsigned int ParseFlags = rapidjson::ParseFlag::kParseDefaultFlags>
+JSON_UTILS_NODISCARD ContainerType
+deserialize_via_dom(const std::filesystem::path& path, compressed_tag)
+{
+    compressed_input_stream stream{ path };
+    return detail::deserialize<ContainerType, rapidjson::UTF8<>, ParseFlags>(stream);
+}
+
 template <
     typename ContainerType, unsigned int ParseFlags = rapidjson::ParseFlag::kParseDefaultFlags>
 JSON_UTILS_NODISCARD ContainerType deserialize_via_sax(const char* const json)
@@ -181,5 +552,58 @@ JSON_UTILS_NODISCARD ContainerType deserialize_via_sax(const std::filesystem::pa
     return sax_deserializer::detail::from_json<ContainerType, ParseFlags>(path);
 }
 
+/**
+ * Deserializes a file that may be compressed (as determined by its magic bytes), decompressing it
+ * on a helper thread while it's being parsed.
+ **/
+template <
+    typename ContainerType, unsigned int ParseFlags = rapidjson::ParseFlag::kParseDefaultFlags>
+JSON_UTILS_NODISCARD ContainerType
+deserialize_via_sax(const std::filesystem::path& path, compressed_tag)
+{
+    compressed_input_stream stream{ path };
+
+    ContainerType container;
+    sax_deserializer::detail::parse_stream<rapidjson::UTF8<>, ParseFlags>(stream, container);
+
+    return container;
+}
+
+/**
+ * Deserializes a MessagePack document through the same handlers as `deserialize_via_sax(...)`.
+ *
+ * @throws std::runtime_error if the document is malformed, or can't be represented as JSON.
+ **/
+template <typename ContainerType>
+JSON_UTILS_NODISCARD ContainerType
+deserialize_msgpack(const std::uint8_t* const data, std::size_t size)
+{
+    return sax_deserializer::detail::from_binary<ContainerType, msgpack_reader>(data, size);
+}
+
+template <typename ContainerType>
+JSON_UTILS_NODISCARD ContainerType deserialize_msgpack(const std::vector<std::uint8_t>& data)
+{
+    return deserialize_msgpack<ContainerType>(data.data(), data.size());
+}
+
+/**
+ * Deserializes a CBOR document through the same handlers as `deserialize_via_sax(...)`.
+ *
+ * @throws std::runtime_error if the document is malformed, or can't be represented as JSON.
+ **/
+template <typename ContainerType>
+JSON_UTILS_NODISCARD ContainerType
+deserialize_cbor(const std::uint8_t* const data, std::size_t size)
+{
+    return sax_deserializer::detail::from_binary<ContainerType, cbor_reader>(data, size);
+}
+
+template <typename ContainerType>
+JSON_UTILS_NODISCARD ContainerType deserialize_cbor(const std::vector<std::uint8_t>& data)
+{
+    return deserialize_cbor<ContainerType>(data.data(), data.size());
+}
+
 #endif
 } // namespace json_utils
@@ -0,0 +1,1119 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+#if __cplusplus >= 201703L // C++17
+#include <charconv>
+#endif
+
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/rapidjson.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+#include "future_std.h"
+#include "json_output_streams.h"
+#include "json_serialization_options.h"
+
+// clang-format off
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    #define JSON_UTILS_X86_RUNTIME_DISPATCH
+    #include <immintrin.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define JSON_UTILS_SSE2
+    #include <emmintrin.h>
+#endif
+
+#if defined(JSON_UTILS_SSE2) && defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+#if __cplusplus >= 201703L && defined(__cpp_lib_to_chars)
+    #define JSON_UTILS_FLOATING_POINT_TO_CHARS
+#endif
+// clang-format on
+
+namespace json_utils
+{
+/**
+ * Wraps a string that the caller has already validated as printable ASCII (i.e., a string that
+ * contains no quotation marks, backslashes, or control characters). Serializing such a string skips
+ * the escape scan entirely.
+ *
+ * @note The wrapper does not own the string that it refers to.
+ **/
+class trusted_ascii
+{
+  public:
+    explicit trusted_ascii(const char* data) noexcept
+        : m_data{ data }, m_size{ std::char_traits<char>::length(data) }
+    {
+    }
+
+    trusted_ascii(const char* data, std::size_t size) noexcept : m_data{ data }, m_size{ size }
+    {
+    }
+
+    explicit trusted_ascii(const std::string& data) noexcept
+        : m_data{ data.data() }, m_size{ data.size() }
+    {
+    }
+
+    const char* data() const noexcept
+    {
+        return m_data;
+    }
+
+    std::size_t size() const noexcept
+    {
+        return m_size;
+    }
+
+  private:
+    const char* m_data;
+    std::size_t m_size;
+};
+
+/**
+ * Wraps a string whose storage the caller guarantees will outlive the output, and remain unchanged
+ * until the output has been consumed. Output streams that can refer to such data instead of copying
+ * it (i.e., the `segment_output_stream`) reference long runs of it in place; every other stream
+ * copies it like any other string.
+ *
+ * @note The wrapper does not own the string that it refers to.
+ **/
+class stable_string
+{
+  public:
+    stable_string(const char* data, std::size_t size) noexcept : m_data{ data }, m_size{ size }
+    {
+    }
+
+    explicit stable_string(const std::string& data) noexcept
+        : m_data{ data.data() }, m_size{ data.size() }
+    {
+    }
+
+    // A temporary would be destroyed long before the output that refers to it is consumed.
+    explicit stable_string(std::string&& data) = delete;
+
+    const char* data() const noexcept
+    {
+        return m_data;
+    }
+
+    std::size_t size() const noexcept
+    {
+        return m_size;
+    }
+
+  private:
+    const char* m_data;
+    std::size_t m_size;
+};
+
+namespace detail
+{
+using escape_scanner = const char* (*)(const char*, const char*);
+
+inline bool requires_escaping(unsigned char character) noexcept
+{
+    return character < 0x20 || character == '"' || character == '\\';
+}
+
+inline const char* find_escape_scalar(const char* begin, const char* end) noexcept
+{
+    while (begin != end && !requires_escaping(static_cast<unsigned char>(*begin))) {
+        ++begin;
+    }
+
+    return begin;
+}
+
+#ifdef JSON_UTILS_SSE2
+
+/**
+ * @returns The index of the lowest set bit in the mask, which must not be zero.
+ **/
+inline unsigned int lowest_set_bit(unsigned int mask) noexcept
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+
+    return static_cast<unsigned int>(index);
+#else
+    return static_cast<unsigned int>(__builtin_ctz(mask));
+#endif
+}
+
+inline const char* find_escape_sse2(const char* begin, const char* end) noexcept
+{
+    const auto quote = _mm_set1_epi8('"');
+    const auto backslash = _mm_set1_epi8('\\');
+    const auto last_control_character = _mm_set1_epi8(0x1F);
+
+    while (end - begin >= 16) {
+        const auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+
+        // SSE2 lacks an unsigned comparison, but `min(x, 0x1F) == x` is equivalent to `x <= 0x1F`.
+        const auto is_control = _mm_cmpeq_epi8(_mm_min_epu8(chunk, last_control_character), chunk);
+        const auto is_quote = _mm_cmpeq_epi8(chunk, quote);
+        const auto is_backslash = _mm_cmpeq_epi8(chunk, backslash);
+
+        const auto mask = static_cast<unsigned int>(
+            _mm_movemask_epi8(_mm_or_si128(is_control, _mm_or_si128(is_quote, is_backslash))));
+
+        if (mask != 0) {
+            return begin + lowest_set_bit(mask);
+        }
+
+        begin += 16;
+    }
+
+    return find_escape_scalar(begin, end);
+}
+
+#endif
+
+#ifdef JSON_UTILS_X86_RUNTIME_DISPATCH
+
+__attribute__((target("avx2"))) inline const char*
+find_escape_avx2(const char* begin, const char* end) noexcept
+{
+    const auto quote = _mm256_set1_epi8('"');
+    const auto backslash = _mm256_set1_epi8('\\');
+    const auto last_control_character = _mm256_set1_epi8(0x1F);
+
+    while (end - begin >= 32) {
+        const auto chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+
+        const auto is_control =
+            _mm256_cmpeq_epi8(_mm256_min_epu8(chunk, last_control_character), chunk);
+        const auto is_quote = _mm256_cmpeq_epi8(chunk, quote);
+        const auto is_backslash = _mm256_cmpeq_epi8(chunk, backslash);
+
+        const auto mask = static_cast<unsigned int>(_mm256_movemask_epi8(
+            _mm256_or_si256(is_control, _mm256_or_si256(is_quote, is_backslash))));
+
+        if (mask != 0) {
+            return begin + __builtin_ctz(mask);
+        }
+
+        begin += 32;
+    }
+
+    return find_escape_scalar(begin, end);
+}
+
+__attribute__((target("avx512f,avx512bw"))) inline const char*
+find_escape_avx512(const char* begin, const char* end) noexcept
+{
+    const auto quote = _mm512_set1_epi8('"');
+    const auto backslash = _mm512_set1_epi8('\\');
+    const auto space = _mm512_set1_epi8(0x20);
+
+    while (end - begin >= 64) {
+        const auto chunk = _mm512_loadu_si512(reinterpret_cast<const void*>(begin));
+
+        const auto mask = _mm512_cmplt_epu8_mask(chunk, space) |
+                          _mm512_cmpeq_epi8_mask(chunk, quote) |
+                          _mm512_cmpeq_epi8_mask(chunk, backslash);
+
+        if (mask != 0) {
+            return begin + __builtin_ctzll(mask);
+        }
+
+        begin += 64;
+    }
+
+    return find_escape_scalar(begin, end);
+}
+
+#endif
+
+/**
+ * Selects the widest escape scanning kernel that the current CPU supports.
+ **/
+inline escape_scanner select_escape_scanner() noexcept
+{
+#ifdef JSON_UTILS_X86_RUNTIME_DISPATCH
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512bw")) {
+        return find_escape_avx512;
+    }
+
+    if (__builtin_cpu_supports("avx2")) {
+        return find_escape_avx2;
+    }
+#endif
+
+#ifdef JSON_UTILS_SSE2
+    return find_escape_sse2;
+#else
+    return find_escape_scalar;
+#endif
+}
+
+/**
+ * @returns A pointer to the first character in the range that must be escaped, or `end` if there
+ * is no such character.
+ **/
+inline const char* find_escape(const char* begin, const char* end) noexcept
+{
+    static const escape_scanner scanner = select_escape_scanner();
+    return scanner(begin, end);
+}
+
+template <typename, typename, typename = void> struct has_write_member : std::false_type
+{
+};
+
+template <typename StreamType, typename CharacterType>
+struct has_write_member<
+    StreamType, CharacterType,
+    future_std::void_t<decltype(std::declval<StreamType&>().write(
+        std::declval<const CharacterType*>(), std::declval<std::size_t>()))>> : std::true_type
+{
+};
+
+template <typename EncodingType, typename AllocatorType>
+void put_range(
+    rapidjson::GenericStringBuffer<EncodingType, AllocatorType>& stream,
+    const typename EncodingType::Ch* data, std::size_t length)
+{
+    if (length != 0) {
+        std::memcpy(stream.Push(length), data, length * sizeof(typename EncodingType::Ch));
+    }
+}
+
+template <typename StreamType>
+auto put_range(StreamType& stream, const typename StreamType::Ch* data, std::size_t length)
+    -> std::enable_if_t<has_write_member<StreamType, typename StreamType::Ch>::value>
+{
+    stream.write(data, length);
+}
+
+template <typename StreamType>
+auto put_range(StreamType& stream, const typename StreamType::Ch* data, std::size_t length)
+    -> std::enable_if_t<!has_write_member<StreamType, typename StreamType::Ch>::value>
+{
+    for (std::size_t index = 0; index < length; ++index) {
+        stream.Put(data[index]);
+    }
+}
+
+template <typename, typename = void> struct has_refer_member : std::false_type
+{
+};
+
+template <typename StreamType>
+struct has_refer_member<
+    StreamType, future_std::void_t<decltype(std::declval<StreamType&>().refer(
+                    std::declval<const typename StreamType::Ch*>(), std::declval<std::size_t>()))>>
+    : std::true_type
+{
+};
+
+/**
+ * Forwards everything to the underlying stream, except for the flushes that rapidjson issues at the
+ * end of every document. This is needed when several documents (or fragments of a document) are
+ * written to the same stream through a writer that's reset in between; otherwise, each one would be
+ * handed to the operating system (or to a chunk callback) on its own.
+ **/
+template <typename OutputStreamType> class deferred_flush_stream
+{
+  public:
+    using Ch = typename OutputStreamType::Ch;
+
+    explicit deferred_flush_stream(OutputStreamType& stream) noexcept : m_stream{ stream }
+    {
+    }
+
+    void Put(Ch character)
+    {
+        m_stream.Put(character);
+    }
+
+    void Flush() noexcept
+    {
+    }
+
+    void write(const Ch* data, std::size_t length)
+    {
+        put_range(m_stream, data, length);
+    }
+
+    OutputStreamType& underlying() noexcept
+    {
+        return m_stream;
+    }
+
+  private:
+    OutputStreamType& m_stream;
+};
+
+/**
+ * Hands runs of characters that are long enough to the stream by reference, rather than copying
+ * them, for streams that support this (see `segment_output_stream`).
+ **/
+template <typename StreamType> struct referencing_run_writer
+{
+    void operator()(const char* data, std::size_t length) const
+    {
+        if (length >= stream.minimum_reference_size()) {
+            stream.refer(data, length);
+        } else {
+            put_range(stream, data, length);
+        }
+    }
+
+    StreamType& stream;
+};
+
+/**
+ * Writes a quoted and escaped string to the output stream. Runs of characters that don't require
+ * escaping are located with the fastest available SIMD kernel, and are then handed to the
+ * `write_run` callable, which is invoked as `write_run(const char* data, std::size_t length)`.
+ *
+ * The output is identical to what `rapidjson::Writer<...>` produces for UTF-8 input and output.
+ **/
+template <typename StreamType, typename RunWriterType>
+bool write_escaped_string(
+    StreamType& stream, const char* data, std::size_t length, const RunWriterType& write_run)
+{
+    static constexpr char hex_digits[] = "0123456789ABCDEF";
+
+    const char* const end = data + length;
+
+    stream.Put('"');
+
+    while (data != end) {
+        const char* const next = find_escape(data, end);
+        write_run(data, static_cast<std::size_t>(next - data));
+
+        if (next == end) {
+            break;
+        }
+
+        const auto character = static_cast<unsigned char>(*next);
+
+        stream.Put('\\');
+        switch (character) {
+            case '"':
+                stream.Put('"');
+                break;
+            case '\\':
+                stream.Put('\\');
+                break;
+            case '\b':
+                stream.Put('b');
+                break;
+            case '\f':
+                stream.Put('f');
+                break;
+            case '\n':
+                stream.Put('n');
+                break;
+            case '\r':
+                stream.Put('r');
+                break;
+            case '\t':
+                stream.Put('t');
+                break;
+            default:
+                stream.Put('u');
+                stream.Put('0');
+                stream.Put('0');
+                stream.Put(hex_digits[character >> 4]);
+                stream.Put(hex_digits[character & 0xF]);
+        }
+
+        data = next + 1;
+    }
+
+    stream.Put('"');
+
+    return true;
+}
+
+/**
+ * Writes a quoted and escaped string to the output stream, copying runs of characters that don't
+ * require escaping in bulk.
+ **/
+template <typename StreamType>
+bool write_escaped_string(StreamType& stream, const char* data, std::size_t length)
+{
+    return write_escaped_string(
+        stream, data, length, [&stream](const char* run, std::size_t run_length) {
+            put_range(stream, run, run_length);
+        });
+}
+
+template <typename StreamType>
+bool write_unescaped_string(StreamType& stream, const char* data, std::size_t length)
+{
+    stream.Put('"');
+    put_range(stream, data, length);
+    stream.Put('"');
+
+    return true;
+}
+
+/**
+ * Large enough to hold `DBL_MAX` written out in full, with the maximum number of fixed decimals.
+ **/
+constexpr std::size_t number_buffer_size = 512;
+
+/**
+ * Writes a number with exactly the requested number of decimal places.
+ *
+ * @returns A pointer one past the last character written.
+ **/
+inline char* format_fixed(double value, int decimal_places, char* buffer) noexcept
+{
+#ifdef JSON_UTILS_FLOATING_POINT_TO_CHARS
+    return std::to_chars(
+               buffer, buffer + number_buffer_size, value, std::chars_format::fixed,
+               decimal_places)
+        .ptr;
+#else
+    const auto length = std::snprintf(buffer, number_buffer_size, "%.*f", decimal_places, value);
+
+    // The `printf(...)` family honours the global locale, which may use a decimal comma.
+    for (auto index = 0; index < length; ++index) {
+        if (buffer[index] == ',') {
+            buffer[index] = '.';
+        }
+    }
+
+    return buffer + length;
+#endif
+}
+
+/**
+ * The significant digits of the shortest decimal representation that round-trips to a `float`,
+ * such that the value is `0.d1d2d3... * 10^decimal_exponent`.
+ **/
+struct shortest_digits
+{
+    char digits[16];
+    int length = 0;
+    int decimal_exponent = 0;
+    bool is_negative = false;
+};
+
+/**
+ * Splits the output of `printf("%e")` or of `std::to_chars(..., std::chars_format::scientific)`
+ * into its significant digits and its exponent. Anything other than a digit before the exponent
+ * (i.e., the sign and the decimal point, which may be locale-specific) is skipped.
+ **/
+inline shortest_digits parse_scientific(const char* begin, const char* end) noexcept
+{
+    shortest_digits result;
+    result.is_negative = begin != end && *begin == '-';
+
+    while (begin != end && *begin != 'e') {
+        if (*begin >= '0' && *begin <= '9') {
+            result.digits[result.length++] = *begin;
+        }
+
+        ++begin;
+    }
+
+    if (begin != end) {
+        ++begin;
+    }
+
+    const bool has_negative_exponent = begin != end && *begin == '-';
+
+    int exponent = 0;
+    for (; begin != end; ++begin) {
+        if (*begin >= '0' && *begin <= '9') {
+            exponent = exponent * 10 + (*begin - '0');
+        }
+    }
+
+    result.decimal_exponent = (has_negative_exponent ? -exponent : exponent) + 1;
+    return result;
+}
+
+#ifdef JSON_UTILS_FLOATING_POINT_TO_CHARS
+
+inline shortest_digits find_shortest_digits(float value) noexcept
+{
+    char buffer[32];
+    const char* const end =
+        std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::scientific).ptr;
+
+    return parse_scientific(buffer, end);
+}
+
+#else
+
+/**
+ * Finds the fewest significant digits that round-trip by trying each precision in turn. Since
+ * `printf(...)` and `strtof(...)` honour the same locale, the comparison is unaffected by it.
+ **/
+inline shortest_digits find_shortest_digits(float value) noexcept
+{
+    char buffer[32];
+    int length = 0;
+
+    for (int precision = 0; precision < std::numeric_limits<float>::max_digits10; ++precision) {
+        length =
+            std::snprintf(buffer, sizeof(buffer), "%.*e", precision, static_cast<double>(value));
+        if (std::strtof(buffer, nullptr) == value) {
+            break;
+        }
+    }
+
+    return parse_scientific(buffer, buffer + length);
+}
+
+#endif
+
+/**
+ * Writes the shortest representation that round-trips to the given `float`, laid out the same way
+ * as rapidjson lays out a `double`: integral values receive a trailing `.0`, so that they are still
+ * read back as floating-point numbers, and the exponential notation is only used for values that
+ * are smaller than `1e-6` or that have more than 21 integral digits.
+ *
+ * @returns A pointer one past the last character written.
+ **/
+inline char* format_shortest(float value, char* buffer) noexcept
+{
+    const auto shortest = find_shortest_digits(value);
+
+    const char* const digits = shortest.digits;
+    const int length = shortest.length;
+    const int point = shortest.decimal_exponent;
+
+    if (shortest.is_negative) {
+        *buffer++ = '-';
+    }
+
+    if (length <= point && point <= 21) {
+        // 1234e7 -> 12340000000.0
+        buffer = std::copy(digits, digits + length, buffer);
+        buffer = std::fill_n(buffer, point - length, '0');
+        *buffer++ = '.';
+        *buffer++ = '0';
+    } else if (0 < point && point <= 21) {
+        // 1234e-2 -> 12.34
+        buffer = std::copy(digits, digits + point, buffer);
+        *buffer++ = '.';
+        buffer = std::copy(digits + point, digits + length, buffer);
+    } else if (-6 < point && point <= 0) {
+        // 1234e-6 -> 0.001234
+        *buffer++ = '0';
+        *buffer++ = '.';
+        buffer = std::fill_n(buffer, -point, '0');
+        buffer = std::copy(digits, digits + length, buffer);
+    } else {
+        // 1234e30 -> 1.234e33, and 1e-7 -> 1e-7
+        *buffer++ = digits[0];
+        if (length > 1) {
+            *buffer++ = '.';
+            buffer = std::copy(digits + 1, digits + length, buffer);
+        }
+
+        *buffer++ = 'e';
+
+        auto exponent = point - 1;
+        if (exponent < 0) {
+            *buffer++ = '-';
+            exponent = -exponent;
+        }
+
+        if (exponent >= 10) {
+            *buffer++ = static_cast<char>('0' + exponent / 10);
+        }
+
+        *buffer++ = static_cast<char>('0' + exponent % 10);
+    }
+
+    return buffer;
+}
+
+/**
+ * @returns The `double` that is closest to the shortest decimal representation of the given
+ * `float`, such that `0.1f` becomes `0.1`, and not `0.100000001490116`.
+ **/
+inline double widen_shortest(float value) noexcept
+{
+    const auto shortest = find_shortest_digits(value);
+
+    // Written without a decimal point (e.g., `-1e-1`), so that parsing it is locale-independent.
+    char buffer[32];
+    char* end = buffer;
+
+    if (shortest.is_negative) {
+        *end++ = '-';
+    }
+
+    end = std::copy(shortest.digits, shortest.digits + shortest.length, end);
+    end += std::snprintf(
+        end, static_cast<std::size_t>(buffer + sizeof(buffer) - end), "e%d",
+        shortest.decimal_exponent - shortest.length);
+
+#ifdef JSON_UTILS_FLOATING_POINT_TO_CHARS
+    double result = value;
+    std::from_chars(buffer, end, result);
+
+    return result;
+#else
+    return std::strtod(buffer, nullptr);
+#endif
+}
+
+template <typename WriterType> struct writer_traits;
+
+template <
+    typename OutputStreamType, typename SourceEncodingType, typename TargetEncodingType,
+    typename StackAllocatorType, unsigned WriteFlags>
+struct writer_traits<rapidjson::Writer<
+    OutputStreamType, SourceEncodingType, TargetEncodingType, StackAllocatorType, WriteFlags>>
+{
+    using output_stream_type = OutputStreamType;
+    using source_encoding_type = SourceEncodingType;
+    using target_encoding_type = TargetEncodingType;
+
+    static constexpr bool is_pretty = false;
+
+    static constexpr bool supports_fast_escaping =
+        std::is_same<SourceEncodingType, rapidjson::UTF8<char>>::value &&
+        std::is_same<TargetEncodingType, rapidjson::UTF8<char>>::value &&
+        !(WriteFlags & rapidjson::kWriteValidateEncodingFlag);
+};
+
+template <
+    typename OutputStreamType, typename SourceEncodingType, typename TargetEncodingType,
+    typename StackAllocatorType, unsigned WriteFlags>
+struct writer_traits<rapidjson::PrettyWriter<
+    OutputStreamType, SourceEncodingType, TargetEncodingType, StackAllocatorType, WriteFlags>>
+    : writer_traits<rapidjson::Writer<
+          OutputStreamType, SourceEncodingType, TargetEncodingType, StackAllocatorType, WriteFlags>>
+{
+    static constexpr bool is_pretty = true;
+};
+
+/**
+ * Tracks the objects that have been reached through a `std::shared_ptr<...>` during a single
+ * serialization, for the `memoize` and `reference` shared pointer policies.
+ **/
+struct shared_pointer_memo
+{
+    /**
+     * Objects are identified by their address as well as their type, since an object and its first
+     * member share the same address.
+     **/
+    using key_type = std::pair<const void*, const void*>;
+
+    struct key_hash
+    {
+        std::size_t operator()(const key_type& key) const noexcept
+        {
+            const std::hash<const void*> hash;
+            return hash(key.first) ^ (hash(key.second) << 1);
+        }
+    };
+
+    /**
+     * The JSON of an object is not copied into its entry, but located within the stream that it
+     * was first written to, so that the JSON of nested objects isn't held more than once.
+     **/
+    struct entry
+    {
+        std::uint64_t id;
+
+        const string_output_stream<>* stream;
+        std::size_t offset;
+        std::size_t length;
+
+        bool is_complete;
+        bool is_identified;
+        bool is_referenced;
+    };
+
+    template <typename DataType> static key_type key_of(const DataType& data) noexcept
+    {
+        static const char type_tag = 0;
+        return { static_cast<const void*>(std::addressof(data)), &type_tag };
+    }
+
+    /**
+     * Discards the record of the objects written so far, but not the last identifier handed out.
+     **/
+    void clear() noexcept
+    {
+        entries.clear();
+        arena.clear();
+    }
+
+    std::unordered_map<key_type, entry, key_hash> entries;
+
+    /**
+     * Holds the JSON of the objects that were written by a writer whose output stream doesn't
+     * retain its output, so that it can be replayed.
+     **/
+    string_output_stream<> arena;
+
+    /**
+     * Identifiers keep increasing across resets, so that they remain unique within a document
+     * that is written in several parts.
+     **/
+    std::uint64_t last_id = 0;
+};
+
+/**
+ * Extends either a `rapidjson::Writer<...>` or a `rapidjson::PrettyWriter<...>` with faster string
+ * escaping. Since the adaptor derives from the writer that it extends, it can be passed to any
+ * `to_json(...)` overload that accepts the underlying rapidjson writer.
+ **/
+template <typename BaseWriterType> class writer_adaptor : public BaseWriterType
+{
+    using traits = writer_traits<BaseWriterType>;
+    using fast_path = std::integral_constant<bool, traits::supports_fast_escaping>;
+
+  public:
+    using Ch = typename BaseWriterType::Ch;
+
+    using BaseWriterType::BaseWriterType;
+
+    bool String(const Ch* data, rapidjson::SizeType length, bool copy = false)
+    {
+        return write_string(data, length, copy, fast_path{});
+    }
+
+    bool String(const Ch* data)
+    {
+        return String(data, rapidjson::internal::StrLen(data));
+    }
+
+    bool Key(const Ch* data, rapidjson::SizeType length, bool copy = false)
+    {
+        return String(data, length, copy);
+    }
+
+    bool Key(const Ch* data)
+    {
+        return String(data, rapidjson::internal::StrLen(data));
+    }
+
+#if RAPIDJSON_HAS_STDSTRING
+    bool String(const std::basic_string<Ch>& data)
+    {
+        return String(data.data(), static_cast<rapidjson::SizeType>(data.size()));
+    }
+
+    bool Key(const std::basic_string<Ch>& data)
+    {
+        return String(data.data(), static_cast<rapidjson::SizeType>(data.size()));
+    }
+#endif
+
+    bool Double(double value)
+    {
+        if (m_options.numbers.get_style() == number_format::style::fixed && std::isfinite(value)) {
+            char buffer[number_buffer_size];
+            const char* const end =
+                format_fixed(value, m_options.numbers.get_decimal_places(), buffer);
+
+            return write_number(buffer, static_cast<std::size_t>(end - buffer));
+        }
+
+        return BaseWriterType::Double(value);
+    }
+
+    /**
+     * Writes a `float` without first promoting it to a `double`, so that only as many digits as
+     * are needed to round-trip the `float` are written.
+     **/
+    bool Float(float value)
+    {
+        if (!std::isfinite(value)) {
+            // Defer to rapidjson's handling of NaN and infinity.
+            return BaseWriterType::Double(static_cast<double>(value));
+        }
+
+        switch (m_options.numbers.get_style()) {
+            case number_format::style::fixed:
+                return Double(static_cast<double>(value));
+            case number_format::style::max_decimal_places:
+                return BaseWriterType::Double(widen_shortest(value));
+            case number_format::style::shortest: {
+                char buffer[number_buffer_size];
+                const char* const end = format_shortest(value, buffer);
+
+                return write_number(buffer, static_cast<std::size_t>(end - buffer));
+            }
+            default:
+                return BaseWriterType::Double(static_cast<double>(value));
+        }
+    }
+
+    void set_options(const serialization_options& options)
+    {
+        apply_options(options);
+
+        m_memo = options.shared_pointers == shared_pointer_policy::expand
+                     ? nullptr
+                     : std::make_shared<shared_pointer_memo>();
+    }
+
+    /**
+     * Adopts the options of another writer, along with its record of the shared objects that have
+     * been written, so that a part of the same document can be written out separately.
+     **/
+    template <typename OtherWriterType> void inherit_options(const OtherWriterType& parent)
+    {
+        apply_options(parent.get_options());
+        m_memo = parent.get_memo();
+    }
+
+    const serialization_options& get_options() const noexcept
+    {
+        return m_options;
+    }
+
+    /**
+     * @returns The record of shared objects written so far, or null if shared pointers are to be
+     * expanded.
+     **/
+    const std::shared_ptr<shared_pointer_memo>& get_memo() const noexcept
+    {
+        return m_memo;
+    }
+
+    /**
+     * Prepares the writer for another document, which starts with no shared objects written.
+     **/
+    void Reset(typename traits::output_stream_type& stream)
+    {
+        start_value(stream);
+
+        if (m_memo != nullptr) {
+            m_memo->clear();
+        }
+    }
+
+    /**
+     * Prepares the writer for another value of the same document, which may still refer to the
+     * shared objects written so far.
+     **/
+    void start_value(typename traits::output_stream_type& stream)
+    {
+        BaseWriterType::Reset(stream);
+        m_pending = pending_identifier{};
+    }
+
+    /**
+     * Starts an object, and gives it an `"$id"` member if it is the value that is being written by
+     * `write_identified(...)`.
+     **/
+    bool StartObject()
+    {
+        const bool is_identified =
+            m_pending.id != 0 && !m_pending.is_written && m_pending.depth == depth();
+
+        const bool result = BaseWriterType::StartObject();
+        if (!is_identified) {
+            return result;
+        }
+
+        m_pending.is_written = true;
+
+        static const Ch key[] = { '$', 'i', 'd' };
+        return Key(key, 3) && BaseWriterType::Uint64(m_pending.id);
+    }
+
+    /**
+     * Invokes the given function to write a single value, and gives that value an `"$id"` member
+     * if it turns out to be a JSON object.
+     *
+     * @returns True if the value was given the identifier.
+     **/
+    template <typename FunctionType> bool write_identified(std::uint64_t id, FunctionType&& write)
+    {
+        const auto previous = m_pending;
+        m_pending = pending_identifier{ id, depth(), false };
+
+        write();
+
+        const bool is_identified = m_pending.is_written;
+        m_pending = previous;
+
+        return is_identified;
+    }
+
+    typename traits::output_stream_type& output_stream() noexcept
+    {
+        return *this->os_;
+    }
+
+    /**
+     * @returns The number of arrays and objects that are currently open.
+     **/
+    std::size_t depth() const noexcept
+    {
+        return this->level_stack_.GetSize() / sizeof(typename BaseWriterType::Level);
+    }
+
+    /**
+     * Writes a string without scanning it for characters that require escaping. The caller is
+     * responsible for ensuring that no such characters are present.
+     **/
+    bool unescaped_string(const Ch* data, rapidjson::SizeType length)
+    {
+        return write_unescaped(data, length, fast_path{});
+    }
+
+    /**
+     * Writes a string whose storage is known to outlive the output (see `stable_string`). If the
+     * output stream can refer to such data instead of copying it (as the `segment_output_stream`
+     * can), long runs of characters that don't require escaping are referenced in place.
+     **/
+    bool external_string(const Ch* data, rapidjson::SizeType length)
+    {
+        using can_refer = std::integral_constant<
+            bool, traits::supports_fast_escaping &&
+                      has_refer_member<typename traits::output_stream_type>::value>;
+
+        return write_external(data, length, can_refer{});
+    }
+
+  protected:
+    void prefix(rapidjson::Type type)
+    {
+        prefix(type, std::integral_constant<bool, traits::is_pretty>{});
+    }
+
+  private:
+    void apply_options(const serialization_options& options)
+    {
+        m_options = options;
+
+        BaseWriterType::SetMaxDecimalPlaces(
+            options.numbers.get_style() == number_format::style::max_decimal_places
+                ? options.numbers.get_decimal_places()
+                : BaseWriterType::kDefaultMaxDecimalPlaces);
+    }
+
+    void prefix(rapidjson::Type type, std::false_type)
+    {
+        this->Prefix(type);
+    }
+
+    void prefix(rapidjson::Type type, std::true_type)
+    {
+        this->PrettyPrefix(type);
+    }
+
+    bool write_string(const Ch* data, rapidjson::SizeType length, bool /*copy*/, std::true_type)
+    {
+        prefix(rapidjson::kStringType);
+        return this->EndValue(write_escaped_string(*this->os_, data, length));
+    }
+
+    bool write_string(const Ch* data, rapidjson::SizeType length, bool copy, std::false_type)
+    {
+        return BaseWriterType::String(data, length, copy);
+    }
+
+    bool write_external(const Ch* data, rapidjson::SizeType length, std::true_type)
+    {
+        auto& stream = *this->os_;
+        const referencing_run_writer<typename traits::output_stream_type> write_run{ stream };
+
+        prefix(rapidjson::kStringType);
+        return this->EndValue(write_escaped_string(stream, data, length, write_run));
+    }
+
+    bool write_external(const Ch* data, rapidjson::SizeType length, std::false_type)
+    {
+        return String(data, length);
+    }
+
+    bool write_unescaped(const Ch* data, rapidjson::SizeType length, std::true_type)
+    {
+        prefix(rapidjson::kStringType);
+        return this->EndValue(write_unescaped_string(*this->os_, data, length));
+    }
+
+    bool write_unescaped(const Ch* data, rapidjson::SizeType length, std::false_type)
+    {
+        return BaseWriterType::String(data, length);
+    }
+
+    bool write_number(const char* data, std::size_t length)
+    {
+        return write_number(data, length, std::is_same<Ch, char>{});
+    }
+
+    bool write_number(const char* data, std::size_t length, std::true_type)
+    {
+        return BaseWriterType::RawValue(data, length, rapidjson::kNumberType);
+    }
+
+    bool write_number(const char* data, std::size_t length, std::false_type)
+    {
+        Ch buffer[number_buffer_size];
+        std::copy(data, data + length, buffer);
+
+        return BaseWriterType::RawValue(buffer, length, rapidjson::kNumberType);
+    }
+
+    /**
+     * The identifier to give to the next object that is started at the given depth.
+     **/
+    struct pending_identifier
+    {
+        std::uint64_t id = 0;
+        std::size_t depth = 0;
+        bool is_written = false;
+    };
+
+    serialization_options m_options;
+    std::shared_ptr<shared_pointer_memo> m_memo;
+    pending_identifier m_pending;
+};
+
+template <typename BaseWriterType>
+struct writer_traits<writer_adaptor<BaseWriterType>> : writer_traits<BaseWriterType>
+{
+};
+} // namespace detail
+
+template <
+    typename OutputStreamType, typename SourceEncodingType = rapidjson::UTF8<>,
+    typename TargetEncodingType = rapidjson::UTF8<>,
+    typename StackAllocatorType = rapidjson::CrtAllocator,
+    unsigned WriteFlags = rapidjson::kWriteDefaultFlags>
+using writer = detail::writer_adaptor<rapidjson::Writer<
+    OutputStreamType, SourceEncodingType, TargetEncodingType, StackAllocatorType, WriteFlags>>;
+
+template <
+    typename OutputStreamType, typename SourceEncodingType = rapidjson::UTF8<>,
+    typename TargetEncodingType = rapidjson::UTF8<>,
+    typename StackAllocatorType = rapidjson::CrtAllocator,
+    unsigned WriteFlags = rapidjson::kWriteDefaultFlags>
+using pretty_writer = detail::writer_adaptor<rapidjson::PrettyWriter<
+    OutputStreamType, SourceEncodingType, TargetEncodingType, StackAllocatorType, WriteFlags>>;
+} // namespace json_utils
@@ -1,14 +1,18 @@
 #define CATCH_CONFIG_MAIN // This tells Catch to provide a main() - only do this in one cpp file
 #include <catch2/catch.hpp>
 
+#include <algorithm>
+#include <cstdio>
 #include <deque>
 #include <iostream>
+#include <limits>
 #include <list>
 #include <map>
 #include <memory>
 #include <numeric>
 #include <set>
 #include <string>
+#include <tuple>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -21,6 +25,52 @@
 
 namespace
 {
+/**
+ * Terminates a range of integers at the first zero.
+ **/
+struct zero_sentinel
+{
+};
+
+bool operator!=(const int* iterator, zero_sentinel)
+{
+    return *iterator != 0;
+}
+
+/**
+ * A range that, like many views, can only be iterated over when it isn't const.
+ **/
+class even_numbers_view
+{
+  public:
+    explicit even_numbers_view(std::vector<int> numbers) : m_numbers{ std::move(numbers) }
+    {
+    }
+
+    std::vector<int>::const_iterator begin()
+    {
+        filter();
+        return m_numbers.cbegin();
+    }
+
+    std::vector<int>::const_iterator end()
+    {
+        filter();
+        return m_numbers.cend();
+    }
+
+  private:
+    void filter()
+    {
+        const auto is_odd = [](int number) { return number % 2 != 0; };
+        const auto new_end = std::remove_if(m_numbers.begin(), m_numbers.end(), is_odd);
+
+        m_numbers.erase(new_end, m_numbers.end());
+    }
+
+    std::vector<int> m_numbers;
+};
+
 template <typename NumericType> void test_serialization_of_numerics()
 {
     constexpr auto min = std::numeric_limits<NumericType>::min();
@@ -277,6 +327,78 @@ void from_json(
 
     widget.set_data(std::move(data));
 }
+
+struct faulty_widget
+{
+};
+
+template <typename Writer> void to_json(Writer& /*writer*/, const faulty_widget& /*widget*/)
+{
+    throw std::runtime_error{ "Cannot serialize a faulty widget." };
+}
+
+struct coordinate
+{
+    int x;
+    int y;
+
+    friend bool operator<(const coordinate& lhs, const coordinate& rhs) noexcept
+    {
+        return std::tie(lhs.x, lhs.y) < std::tie(rhs.x, rhs.y);
+    }
+};
+
+void to_json_key(json_utils::serializer::key_buffer<char>& buffer, const coordinate& key)
+{
+    char text[32];
+    const auto length = std::snprintf(text, sizeof(text), "%d,%d", key.x, key.y);
+
+    buffer.append(text, static_cast<std::size_t>(length));
+}
+
+enum class color : std::uint8_t
+{
+    red,
+    green,
+    blue
+};
+
+enum class unit
+{
+    celsius,
+    kelvin
+};
+
+std::string to_narrow_json_key(unit key)
+{
+    return key == unit::celsius ? "celsius" : "kelvin";
+}
+
+struct sensor_reading
+{
+    std::string sensor;
+    double value;
+    bool is_valid;
+};
+
+struct graph_node
+{
+    std::string name;
+    std::vector<std::shared_ptr<graph_node>> edges;
+};
+
+template <typename WriterType> void to_json(WriterType& writer, const graph_node& node)
+{
+    writer.StartObject();
+
+    writer.Key("name");
+    json_utils::serializer::to_json(writer, node.name);
+
+    writer.Key("edges");
+    json_utils::serializer::to_json(writer, node.edges);
+
+    writer.EndObject();
+}
 } // namespace sample
 
 template <typename ContainerType>
@@ -302,6 +424,23 @@ bool compare_container_of_pointers(
 }
 } // namespace
 
+namespace json_utils
+{
+template <> struct column_layout<sample::sensor_reading>
+{
+    static auto columns()
+    {
+        const auto scaled = [](const sample::sensor_reading& reading) {
+            return reading.value * 10;
+        };
+
+        return std::make_tuple(
+            column("sensor", &sample::sensor_reading::sensor),
+            column("value", &sample::sensor_reading::value), column("scaled", scaled));
+    }
+};
+} // namespace json_utils
+
 TEST_CASE("Trait Detection")
 {
     SECTION("Container Has emplace_back(...)")
@@ -359,6 +498,21 @@ TEST_CASE("Trait Detection")
         STATIC_REQUIRE_FALSE(json_utils::traits::treat_as_array_sink<char[8]>::value);
         STATIC_REQUIRE_FALSE(json_utils::traits::treat_as_array_sink<wchar_t[8]>::value);
     }
+
+    SECTION("Types with a Structure Known at Compile Time")
+    {
+        using json_utils::traits::is_directly_serializable_v;
+
+        STATIC_REQUIRE(is_directly_serializable_v<std::vector<std::map<std::string, double>>>);
+        STATIC_REQUIRE(is_directly_serializable_v<std::list<std::vector<std::int64_t>>>);
+        STATIC_REQUIRE(is_directly_serializable_v<std::vector<std::pair<std::string, bool>>>);
+        STATIC_REQUIRE(is_directly_serializable_v<float[4]>);
+
+        STATIC_REQUIRE_FALSE(is_directly_serializable_v<std::map<int, int>>);
+        STATIC_REQUIRE_FALSE(is_directly_serializable_v<std::vector<std::wstring>>);
+        STATIC_REQUIRE_FALSE(is_directly_serializable_v<std::vector<std::shared_ptr<int>>>);
+        STATIC_REQUIRE_FALSE(is_directly_serializable_v<std::vector<sample::simple_widget>>);
+    }
 }
 
 TEST_CASE("Serialization of std::vector<...>", "[Standard Containers]")
@@ -564,243 +718,1970 @@ TEST_CASE("Serialization using mixed encodings")
     }
 }
 
-#if __cplusplus >= 201703L // C++17
-
-TEST_CASE("Serialization of C++17 Constructs")
+TEST_CASE("Direct Serialization")
 {
-    SECTION("Array of std::string_view")
-    {
-        constexpr std::string_view hello = "Hello";
-        constexpr std::string_view world = "World";
+    const auto through_writer = [](const auto& data,
+                                   const json_utils::serialization_options& options) {
+        json_utils::string_output_stream<> stream;
+        json_utils::writer<json_utils::string_output_stream<>> writer{ stream };
+        writer.set_options(options);
+
+        json_utils::serializer::to_json(writer, data);
+
+        return stream.release();
+    };
+
+    const std::vector<std::map<std::string, double>> records = {
+        { { "latitude", 52.370216 }, { "longitude", 4.895168 }, { "altitude", -1.5 } },
+        {},
+        { { "zero", 0.0 }, { "tiny", 1e-300 }, { "huge", 1.7976931348623157e308 } }
+    };
+
+    const std::map<std::string, std::vector<std::vector<std::int64_t>>> matrices = {
+        { "Empty", {} },
+        { "Identity", { { 1, 0 }, { 0, 1 } } },
+        { "Limits",
+          { { std::numeric_limits<std::int64_t>::min(),
+              std::numeric_limits<std::int64_t>::max() } } }
+    };
+
+    const std::vector<std::pair<std::string, std::vector<float>>> samples = {
+        { "Needs \"Escaping\"\n", { 0.1f, 1.0f, -2.5e-8f } }, { "Flags", {} }
+    };
+
+    const std::map<std::string, std::string> strings = { { "Empty", "" }, { "Tab", "\t" } };
+    const std::vector<bool> flags = { true, false };
+    const std::uint32_t scalars[] = { 0, 42, std::numeric_limits<std::uint32_t>::max() };
+
+    json_utils::serialization_options options;
+
+    const auto require_identical_output = [&] {
+        const auto require_identical = [&](const auto& data) {
+            REQUIRE(json_utils::serialize_to_json(data, options) == through_writer(data, options));
+        };
 
-        const std::vector<std::string_view> container = { hello, world };
-        const auto json = json_utils::serialize_to_json(container);
+        require_identical(records);
+        require_identical(matrices);
+        require_identical(samples);
+        require_identical(strings);
+        require_identical(flags);
+        require_identical(scalars);
+    };
 
-        REQUIRE(json == R"(["Hello","World"])");
+    SECTION("Default Options")
+    {
+        require_identical_output();
+
+        REQUIRE(
+            json_utils::serialize_to_json(matrices) ==
+            R"({"Empty":[],"Identity":[[1,0],[0,1]],)"
+            R"("Limits":[[-9223372036854775808,9223372036854775807]]})");
     }
 
-    SECTION("Array of std::optional<...> without Nulls")
+    SECTION("Fixed Number Format")
     {
-        const std::vector<std::optional<int>> container = { std::optional<int>{ 101 },
-                                                            std::optional<int>{ 202 } };
-
-        const auto json = json_utils::serialize_to_json(container);
+        options.numbers = json_utils::number_format::fixed(3);
+        require_identical_output();
+    }
 
-        REQUIRE(json == R"([101,202])");
+    SECTION("Limited Number of Decimal Places")
+    {
+        options.numbers = json_utils::number_format::max_decimal_places(2);
+        require_identical_output();
     }
 
-    SECTION("Array of std::optional<...> with Nulls")
+    SECTION("Omitted Members and Aliased Keys")
     {
-        const std::vector<std::optional<int>> container = { std::optional<int>{ 101 }, std::nullopt,
-                                                            std::nullopt,
-                                                            std::optional<int>{ 202 } };
+        const json_utils::key_alias_table aliases{ { "latitude", "lat" }, { "Tab", "t" } };
 
-        const auto json = json_utils::serialize_to_json(container);
+        options.omit_default_members = true;
+        options.key_aliases = &aliases;
 
-        REQUIRE(json == R"([101,null,null,202])");
+        require_identical_output();
     }
 }
 
-#endif
-
-TEST_CASE("Handling Pointer Types")
+TEST_CASE("Serialization with Exact Pre-sizing")
 {
-    SECTION("Using std::unique_ptr<...>")
-    {
-        auto container = std::vector<std::unique_ptr<std::string>>();
-        container.emplace_back(std::make_unique<std::string>("Hello"));
-        container.emplace_back(std::make_unique<std::string>("World"));
+    const std::map<std::string, std::vector<int>> container = { { "Key One", { 1, 2, 3 } },
+                                                                 { "Key Two", { 4, 5 } } };
 
-        const auto json = json_utils::serialize_to_json(container);
+    SECTION("Compact Output Matches Default Serialization")
+    {
+        const auto json = json_utils::serialize_to_json(container, json_utils::exact_size);
 
-        REQUIRE(json == R"(["Hello","World"])");
+        REQUIRE(json == json_utils::serialize_to_json(container));
+        REQUIRE(json == R"({"Key One":[1,2,3],"Key Two":[4,5]})");
     }
 
-    SECTION("Using std::unique_ptr<...> Set to Null")
+    SECTION("Pretty Output Matches Default Serialization")
     {
-        auto container = std::vector<std::unique_ptr<std::string>>();
-        container.emplace_back(std::make_unique<std::string>("Test"));
-        container.emplace_back(nullptr);
+        const auto json = json_utils::serialize_to_pretty_json(container, json_utils::exact_size);
 
-        const auto json = json_utils::serialize_to_json(container);
+        REQUIRE(json == json_utils::serialize_to_pretty_json(container));
+    }
 
-        REQUIRE(json == R"(["Test",null])");
+    SECTION("Wide Output Matches Default Serialization")
+    {
+        const auto json = json_utils::serialize_to_json<rapidjson::UTF8<>, rapidjson::UTF16<>>(
+            container, json_utils::exact_size);
+
+        REQUIRE(json == L"{\"Key One\":[1,2,3],\"Key Two\":[4,5]}");
     }
 
-    SECTION("Using std::shared_ptr<...>")
+    SECTION("Counting Stream Measures Serialization")
     {
-        const auto container =
-            std::vector<std::shared_ptr<std::string>>{ std::make_shared<std::string>("Hello"),
-                                                       std::make_shared<std::string>("World") };
+        json_utils::counting_output_stream<> counter;
+        rapidjson::Writer<decltype(counter)> writer{ counter };
 
-        const auto json = json_utils::serialize_to_json(container);
+        json_utils::serializer::to_json(writer, container);
 
-        REQUIRE(json == R"(["Hello","World"])");
+        REQUIRE(counter.size() == json_utils::serialize_to_json(container).size());
     }
+}
 
-    SECTION("Using std::shared_ptr<...> Set to Null")
+TEST_CASE("Chunked Serialization")
+{
+    std::map<std::string, std::vector<int>> container;
+    for (int index = 0; index < 100; ++index) {
+        container.emplace("Key " + std::to_string(index), std::vector<int>{ index, -index });
+    }
+
+    SECTION("Chunks Are of Fixed Size and Reassemble into the Document")
     {
-        const auto container =
-            std::vector<std::shared_ptr<std::string>>{ std::make_shared<std::string>("Test"),
-                                                       nullptr };
+        std::vector<std::string> chunks;
+        const auto callback = [&](const char* data, std::size_t size) {
+            chunks.emplace_back(data, size);
+        };
+
+        json_utils::serialize_to_json_chunked(container, callback, 64);
 
         const auto json = json_utils::serialize_to_json(container);
 
-        REQUIRE(json == R"(["Test",null])");
+        REQUIRE(chunks.size() == (json.size() + 63) / 64);
+        REQUIRE(std::all_of(
+            std::begin(chunks), std::end(chunks) - 1,
+            [](const std::string& chunk) { return chunk.size() == 64; }));
+
+        const auto reassembled =
+            std::accumulate(std::begin(chunks), std::end(chunks), std::string{});
+        REQUIRE(reassembled == json);
     }
 
-    SECTION("Using std::weak_ptr<...>")
+    SECTION("Pretty Output with Long Strings")
     {
-        const auto pointer_one = std::make_shared<std::string>("Hello");
-        const auto pointer_two = std::make_shared<std::string>("World");
+        const std::vector<std::string> strings = { std::string(1'000, 'a'), "b\n" };
 
-        const auto container = std::vector<std::weak_ptr<std::string>>{ pointer_one, pointer_two };
+        std::string reassembled;
+        const auto callback = [&](const char* data, std::size_t size) {
+            reassembled.append(data, size);
+        };
 
-        const auto json = json_utils::serialize_to_json(container);
+        json_utils::serialize_to_pretty_json_chunked(strings, callback, 7);
 
-        REQUIRE(json == R"(["Hello","World"])");
+        REQUIRE(reassembled == json_utils::serialize_to_pretty_json(strings));
     }
 
-    SECTION("Using std::weak_ptr<...> Set to Null")
+    SECTION("Stream Can Be Used with a Writer Directly")
     {
-        const auto pointer_one = std::make_shared<std::string>("Test");
+        std::size_t total_size = 0;
+        const auto callback = [&](const char* /*data*/, std::size_t size) { total_size += size; };
 
-        const auto container = std::vector<std::weak_ptr<std::string>>{
-            pointer_one, std::make_shared<std::string>("Short lived temporary")
-        };
+        json_utils::chunked_output_stream<decltype(callback)> stream{ callback, 16 };
+        json_utils::writer<decltype(stream)> writer{ stream };
 
-        const auto json = json_utils::serialize_to_json(container);
+        json_utils::serializer::to_json(writer, container);
 
-        REQUIRE(json == R"(["Test",null])");
+        REQUIRE(total_size == json_utils::serialize_to_json(container).size());
+    }
+
+    SECTION("Exceptions Thrown by the Callback Are Propagated")
+    {
+        const auto callback = [](const char* /*data*/, std::size_t /*size*/) {
+            throw std::runtime_error{ "Connection reset." };
+        };
+
+        REQUIRE_THROWS_AS(
+            json_utils::serialize_to_json_chunked(container, callback, 16), std::runtime_error);
     }
 }
 
-TEST_CASE("Serializations of Composite Containers")
+TEST_CASE("Scatter-Gather Serialization")
 {
-    SECTION("std::map<std::string, std::vector<std::shared_ptr<std::string>>>")
+    const std::string body(4'096, 'x');
+    const std::vector<std::string> strings = { "short", body };
+    const std::vector<json_utils::stable_string> stable_strings = {
+        json_utils::stable_string{ strings[0] }, json_utils::stable_string{ strings[1] }
+    };
+
+    SECTION("Long Stable Strings Are Referenced in Place")
     {
-        const std::map<std::string, std::vector<std::shared_ptr<std::string>>> container = {
-            { "Key One",
-              std::vector<std::shared_ptr<std::string>>{
-                  std::make_shared<std::string>("Value 1.A"),
-                  std::make_shared<std::string>("Value 1.B"),
-                  std::make_shared<std::string>("Value 1.C") } },
-            { "Key Two",
-              std::vector<std::shared_ptr<std::string>>{
-                  std::make_shared<std::string>("Value 2.A"),
-                  std::make_shared<std::string>("Value 2.B") } }
-        };
+        json_utils::segment_output_stream stream;
+        json_utils::serialize_to_segments(stable_strings, stream);
 
-        const auto json = json_utils::serialize_to_json(container);
+        const auto segments = stream.segments();
 
-        REQUIRE(
-            json ==
-            R"({"Key One":["Value 1.A","Value 1.B","Value 1.C"],"Key Two":["Value 2.A","Value 2.B"]})");
+        REQUIRE(segments.size() == 3);
+        REQUIRE(segments[1].data == strings[1].data());
+        REQUIRE(segments[1].size == body.size());
+        REQUIRE(stream.str() == json_utils::serialize_to_json(strings));
+        REQUIRE(stream.size() == stream.str().size());
     }
 
-    SECTION("std::map<std::string, std::map<std::string, double>>")
+    SECTION("Other Strings Are Copied")
     {
-        const std::map<std::string, std::map<std::string, double>> container = {
-            { "Key One", std::map<std::string, double>{ { "Subkey One", 16.0 },
-                                                        { "Subkey Two", 32.0 },
-                                                        { "Subkey Three", 64.0 } } },
-            { "Key Two", std::map<std::string, double>{ { "Subkey One", 128.0 },
-                                                        { "Subkey Two", 256.0 },
-                                                        { "Subkey Three", 512.0 } } }
-        };
+        json_utils::segment_output_stream stream;
+        json_utils::serialize_to_segments(strings, stream);
 
-        const auto json = json_utils::serialize_to_json(container);
+        REQUIRE(stream.segments().size() == 1);
+        REQUIRE(stream.str() == json_utils::serialize_to_json(strings));
+    }
 
-        REQUIRE(
-            json == R"({)"
-                    R"("Key One":{"Subkey One":16.0,"Subkey Three":64.0,"Subkey Two":32.0},)"
-                    R"("Key Two":{"Subkey One":128.0,"Subkey Three":512.0,"Subkey Two":256.0})"
-                    R"(})");
+    SECTION("Temporary Strings from a Generator Are Copied")
+    {
+        json_utils::segment_output_stream stream;
+        json_utils::serialize_to_segments(
+            json_utils::generate_array([](auto&& emit) {
+                for (char character = 'a'; character < 'd'; ++character) {
+                    emit(std::string(4'096, character));
+                }
+            }),
+            stream);
+
+        const auto expected = json_utils::serialize_to_json(std::vector<std::string>{
+            std::string(4'096, 'a'), std::string(4'096, 'b'), std::string(4'096, 'c') });
+
+        REQUIRE(stream.segments().size() == 1);
+        REQUIRE(stream.str() == expected);
     }
 
-    SECTION("With a More Complex, Nested Type")
+    SECTION("Projected and Emitted Temporaries Are Copied")
     {
-        const std::vector<std::pair<std::string, std::map<std::string, double>>> container = {
-            { "Key One", std::map<std::string, double>{ { "Subkey One", 16.0 },
-                                                        { "Subkey Two", 32.0 },
-                                                        { "Subkey Three", 64.0 } } },
-            { "Key Two", std::map<std::string, double>{ { "Subkey One", 128.0 },
-                                                        { "Subkey Two", 256.0 },
-                                                        { "Subkey Three", 512.0 } } }
+        const std::vector<int> lengths = { 2'048, 4'096 };
+
+        const auto projected = json_utils::as_object(
+            lengths, [](int length) { return std::to_string(length); },
+            [](int length) { return std::string(static_cast<std::size_t>(length), 'p'); });
+
+        const auto emitted = json_utils::generate_object([&](auto&& emit) {
+            for (const auto length : lengths) {
+                emit(std::to_string(length), std::string(static_cast<std::size_t>(length), 'p'));
+            }
+        });
+
+        const std::map<std::string, std::string> expected = {
+            { "2048", std::string(2'048, 'p') }, { "4096", std::string(4'096, 'p') }
         };
 
-        const auto json = json_utils::serialize_to_pretty_json(container);
+        json_utils::segment_output_stream projected_stream;
+        json_utils::serialize_to_segments(projected, projected_stream);
 
-        REQUIRE(
-            json ==
-            "{\n"
-            "    \"Key One\": {\n"
-            "        \"Subkey One\": 16.0,\n"
-            "        \"Subkey Three\": 64.0,\n"
-            "        \"Subkey Two\": 32.0\n"
-            "    },\n"
-            "    \"Key Two\": {\n"
-            "        \"Subkey One\": 128.0,\n"
-            "        \"Subkey Three\": 512.0,\n"
-            "        \"Subkey Two\": 256.0\n"
-            "    }\n"
-            "}");
+        json_utils::segment_output_stream emitted_stream;
+        json_utils::serialize_to_segments(emitted, emitted_stream);
+
+        REQUIRE(projected_stream.segments().size() == 1);
+        REQUIRE(projected_stream.str() == json_utils::serialize_to_json(expected));
+
+        REQUIRE(emitted_stream.segments().size() == 1);
+        REQUIRE(emitted_stream.str() == json_utils::serialize_to_json(expected));
     }
-}
 
-TEST_CASE("Serializing a Custom Type")
-{
-    SECTION("Custom Type as Key")
+    SECTION("Escape Sequences Split Referenced Runs")
     {
-        const std::vector<std::pair<sample::simple_widget, std::list<std::shared_ptr<std::string>>>>
-            container = {
-                { sample::simple_widget{ "Widget One" },
-                  { std::make_unique<std::string>("1"), std::make_unique<std::string>("2"),
-                    std::make_unique<std::string>("3"), std::make_unique<std::string>("4"),
-                    std::make_unique<std::string>("5"), nullptr } },
-                { sample::simple_widget{ "Widget Two" },
-                  { std::make_unique<std::string>("5"), std::make_unique<std::string>("6"),
-                    std::make_unique<std::string>("7"), std::make_unique<std::string>("8"),
-                    std::make_unique<std::string>("9") } }
-            };
+        const std::string text = std::string(2'000, 'a') + '\n' + std::string(2'000, 'b');
 
-        const auto json = json_utils::serialize_to_json(container);
+        json_utils::segment_output_stream stream{ 1'000 };
+        json_utils::serialize_to_segments(json_utils::stable_string{ text }, stream);
 
-        REQUIRE(
-            json ==
-            R"({"Widget One":["1","2","3","4","5",null],"Widget Two":["5","6","7","8","9"]})");
+        const auto segments = stream.segments();
+
+        REQUIRE(segments.size() == 5);
+        REQUIRE(segments[1].data == text.data());
+        REQUIRE(segments[3].data == text.data() + 2'001);
+        REQUIRE(stream.str() == json_utils::serialize_to_json(text));
     }
 
-    SECTION("Custom Type with Nested Custom Type")
+    SECTION("Pretty Output Matches Default Serialization")
     {
-        const std::vector<sample::composite_widget> container = { sample::composite_widget{
-            "JSON Serialization" } };
+        const std::map<std::string, std::string> container = { { "Body", body } };
 
-        const auto json = json_utils::serialize_to_json(container);
+        json_utils::segment_output_stream stream;
+        json_utils::serialize_to_pretty_segments(container, stream);
 
-        REQUIRE(json == R"([{"Inner Widget":{"Purpose":"JSON Serialization"}}])");
+        REQUIRE(stream.str() == json_utils::serialize_to_pretty_json(container));
     }
 
-    SECTION("Custom Type as Value in std::vector<...>")
+    SECTION("Short Strings Are Copied")
     {
-        const std::vector<sample::simple_widget> container = { sample::simple_widget{
-            "JSON Serialization" } };
+        json_utils::segment_output_stream stream;
+        json_utils::serialize_to_segments(std::vector<std::string>{ "a", "b" }, stream);
 
-        const auto json = json_utils::serialize_to_json(container);
+        REQUIRE(stream.segments().size() == 1);
+        REQUIRE(stream.str() == R"(["a","b"])");
+    }
+
+#ifdef JSON_UTILS_POSIX_FILES
+    SECTION("I/O Vectors Match Segments")
+    {
+        json_utils::segment_output_stream stream;
+        json_utils::serialize_to_segments(stable_strings, stream);
+
+        const auto segments = stream.segments();
+        const auto vectors = stream.to_iovecs();
+
+        REQUIRE(vectors.size() == segments.size());
+
+        for (std::size_t index = 0; index < vectors.size(); ++index) {
+            REQUIRE(vectors[index].iov_base == segments[index].data);
+            REQUIRE(vectors[index].iov_len == segments[index].size);
+        }
+    }
+#endif
+}
+
+TEST_CASE("JSON Lines Output")
+{
+    const std::vector<std::map<std::string, int>> records = { { { "a", 1 } },
+                                                              { { "b", 2 }, { "c", 3 } } };
+
+    SECTION("Records Are Written One per Line")
+    {
+        json_utils::string_output_stream<> stream;
+        json_utils::json_lines_writer<decltype(stream)> writer{ stream };
+
+        writer.write(records[0]);
+        writer.write(std::vector<int>{ 1, 2 });
+        writer.write(std::string{ "text" });
+
+        REQUIRE(stream.str() == "{\"a\":1}\n[1,2]\n\"text\"\n");
+        REQUIRE(writer.record_count() == 3);
+    }
+
+    SECTION("Ranges of Records Are Written in Order")
+    {
+        json_utils::string_output_stream<> stream;
+        json_utils::json_lines_writer<decltype(stream)> writer{ stream };
+
+        writer.write_all(records);
+
+        REQUIRE(stream.str() == "{\"a\":1}\n{\"b\":2,\"c\":3}\n");
+    }
+
+    SECTION("Records Are Not Flushed Individually")
+    {
+        std::size_t flush_count = 0;
+        std::string output;
+        const auto callback = [&](const char* data, std::size_t size) {
+            ++flush_count;
+            output.append(data, size);
+        };
+
+        json_utils::chunked_output_stream<decltype(callback)> stream{ callback };
+        json_utils::json_lines_writer<decltype(stream)> writer{ stream };
+
+        for (int index = 0; index < 100; ++index) {
+            writer.write_all(records);
+        }
+
+        REQUIRE(flush_count == 0);
+
+        writer.flush();
+
+        REQUIRE(flush_count == 1);
+        REQUIRE(std::count(std::begin(output), std::end(output), '\n') == 200);
+    }
+
+    SECTION("Serialization Options Are Honored")
+    {
+        json_utils::serialization_options options;
+        options.numbers = json_utils::number_format::fixed(2);
+
+        json_utils::string_output_stream<> stream;
+        json_utils::json_lines_writer<decltype(stream)> writer{ stream, options };
+
+        writer.write(std::vector<double>{ 1.0 });
+        writer.write(0.5);
+
+        REQUIRE(stream.str() == "[1.00]\n0.50\n");
+    }
+}
+
+TEST_CASE("Precompiled JSON Templates")
+{
+    SECTION("Values Are Spliced into the Skeleton")
+    {
+        const json_utils::json_template<int, std::string, std::vector<double>> message{
+            R"({ "id": ?, "name": ?, "samples": ?, "tags": ["fixed", null, true] })"
+        };
+
+        const auto json = message.render(7, "Line \"1\"\n", { 1.5, 2.0 });
+        const auto expected =
+            R"({"id":7,"name":"Line \"1\"\n","samples":[1.5,2.0],"tags":["fixed",null,true]})";
+
+        REQUIRE(json == expected);
+    }
+
+    SECTION("Rendering Matches Regular Serialization")
+    {
+        const json_utils::json_template<std::map<std::string, int>, bool> message{
+            "[?, 1e3, \"?\", ?]"
+        };
+
+        const std::map<std::string, int> map = { { "a", 1 }, { "b", 2 } };
+        const auto expected = "[" + json_utils::serialize_to_json(map) + ",1e3,\"?\",false]";
+
+        REQUIRE(message.render(map, false) == expected);
+        REQUIRE(message.render(map, false) == expected);
+    }
+
+    SECTION("Templates without Placeholders")
+    {
+        const json_utils::json_template<> message{ R"({ "keyA": null })" };
+
+        REQUIRE(message.render() == R"({"keyA":null})");
+    }
+
+    SECTION("Rendering to an Existing Stream")
+    {
+        const json_utils::json_template<int> message{ "{\"value\":?}" };
+
+        json_utils::string_output_stream<> stream;
+        message.render_to(stream, 1);
+        message.render_to(stream, 2);
+
+        REQUIRE(stream.str() == R"({"value":1}{"value":2})");
+    }
+
+    SECTION("Invalid Skeletons Are Rejected")
+    {
+        using template_type = json_utils::json_template<int>;
+
+        REQUIRE_THROWS_AS(template_type{ "{\"value\": ?" }, std::invalid_argument);
+        REQUIRE_THROWS_AS(template_type{ "{? : 1}" }, std::invalid_argument);
+        REQUIRE_THROWS_AS(template_type{ "[?, ?]" }, std::invalid_argument);
+        REQUIRE_THROWS_AS(template_type{ "[\"?\"]" }, std::invalid_argument);
+    }
+}
+
+TEST_CASE("Resumable Serialization")
+{
+    const auto drain = [](auto& serializer, std::size_t buffer_size) {
+        std::string output;
+        std::vector<char> buffer(buffer_size);
+
+        for (;;) {
+            const auto result = serializer.produce(buffer.data(), buffer.size());
+            output.append(buffer.data(), result.bytes_written);
+
+            if (result.done) {
+                return output;
+            }
+        }
+    };
+
+    SECTION("Nested Containers Match Regular Serialization for Any Buffer Size")
+    {
+        const std::map<std::string, std::vector<std::map<std::string, int>>> container = {
+            { "Empty", {} },
+            { "Key \"One\"", { { { "A", 1 }, { "B", 2 } }, {} } },
+            { "Key Two", { { { "C", 3 } } } }
+        };
+
+        for (const std::size_t buffer_size : { 1, 3, 7, 4096 }) {
+            json_utils::resumable_serializer<> serializer{ container };
+
+            REQUIRE(drain(serializer, buffer_size) == json_utils::serialize_to_json(container));
+        }
+    }
+
+    SECTION("Custom Types and Custom Keys")
+    {
+        const std::vector<sample::simple_widget> widgets(3);
+        const std::map<sample::coordinate, std::string> coordinates = { { { 1, 2 }, "A" } };
+
+        json_utils::resumable_serializer<> widget_serializer{ widgets };
+        json_utils::resumable_serializer<> coordinate_serializer{ coordinates };
+
+        REQUIRE(drain(widget_serializer, 5) == json_utils::serialize_to_json(widgets));
+        REQUIRE(drain(coordinate_serializer, 5) == R"({"1,2":"A"})");
+    }
+
+    SECTION("Shared Objects Are Remembered Across Elements")
+    {
+        const auto leaf = std::make_shared<sample::graph_node>(sample::graph_node{ "leaf", {} });
+        const std::vector<std::shared_ptr<sample::graph_node>> graph{ leaf, leaf, leaf };
+
+        const auto greeting = std::make_shared<std::string>("Hello");
+        const std::vector<std::shared_ptr<std::string>> greetings{ greeting, greeting };
+
+        json_utils::serialization_options options;
+        options.shared_pointers = json_utils::shared_pointer_policy::reference;
+
+        json_utils::resumable_serializer<> graph_serializer{ graph, options };
+        REQUIRE(
+            drain(graph_serializer, 3) ==
+            R"([{"$id":1,"name":"leaf","edges":[]},{"$ref":1},{"$ref":1}])");
+
+        for (const auto policy : { json_utils::shared_pointer_policy::reference,
+                                   json_utils::shared_pointer_policy::memoize }) {
+            options.shared_pointers = policy;
+
+            json_utils::resumable_serializer<> serializer{ greetings, options };
+            REQUIRE(
+                drain(serializer, 3) == json_utils::serialize_to_json(greetings, options));
+        }
+    }
+
+    SECTION("Scalar Root Values")
+    {
+        json_utils::resumable_serializer<> serializer{ std::string{ "Hello" } };
+
+        REQUIRE(drain(serializer, 2) == R"("Hello")");
+    }
+
+    SECTION("Serialization Can Be Paused")
+    {
+        const std::vector<int> container = { 1, 2, 3 };
+        json_utils::resumable_serializer<> serializer{ container };
+
+        char buffer[4];
+
+        auto result = serializer.produce(buffer, 0);
+        REQUIRE(result.bytes_written == 0);
+        REQUIRE_FALSE(result.done);
+
+        result = serializer.produce(buffer, sizeof(buffer));
+        REQUIRE(std::string(buffer, result.bytes_written) == "[1,2");
+        REQUIRE_FALSE(result.done);
+
+        result = serializer.produce(buffer, sizeof(buffer));
+        REQUIRE(std::string(buffer, result.bytes_written) == ",3]");
+        REQUIRE(result.done);
+        REQUIRE(serializer.done());
+    }
+}
+
+TEST_CASE("Parallel Serialization")
+{
+    SECTION("Large Array Matches Serial Output")
+    {
+        std::vector<int> container(100'000);
+        std::iota(std::begin(container), std::end(container), -50'000);
+
+        const auto json = json_utils::serialize_to_json_parallel(container, 8);
+
+        REQUIRE(json == json_utils::serialize_to_json(container));
+    }
+
+    SECTION("Large Object Matches Serial Output")
+    {
+        std::map<std::string, std::vector<int>> container;
+        for (int index = 0; index < 10'000; ++index) {
+            container.emplace(std::to_string(index), std::vector<int>{ index, index * 2 });
+        }
+
+        const auto json = json_utils::serialize_to_json_parallel(container, 4);
+
+        REQUIRE(json == json_utils::serialize_to_json(container));
+    }
+
+    SECTION("Pretty Output Matches Serial Output")
+    {
+        std::list<std::pair<std::string, double>> container;
+        for (int index = 0; index < 5'000; ++index) {
+            container.emplace_back(std::to_string(index), index / 4.0);
+        }
+
+        const auto json = json_utils::serialize_to_pretty_json_parallel(container, 3);
+
+        REQUIRE(json == json_utils::serialize_to_pretty_json(container));
+    }
+
+    SECTION("Spliced Text Ending in a Line Break Matches Serial Output")
+    {
+        const std::vector<json_utils::raw_json> container(1'000, json_utils::raw_json{ "1\n" });
+
+        const auto json = json_utils::serialize_to_json_parallel(container, 4);
+
+        REQUIRE(json == json_utils::serialize_to_json(container));
+    }
+
+    SECTION("Chunks Whose Members Are All Omitted Are Skipped")
+    {
+        json_utils::serialization_options options;
+        options.omit_null_members = true;
+
+        // The leading and trailing quarters, each spanning several chunks, are omitted entirely.
+        std::map<std::string, std::shared_ptr<int>> container;
+        for (int index = 1'000; index < 3'000; ++index) {
+            const bool is_omitted = index < 1'500 || index >= 2'500;
+            container.emplace(
+                std::to_string(index), is_omitted ? nullptr : std::make_shared<int>(index));
+        }
+
+        REQUIRE(
+            json_utils::serialize_to_json_parallel(container, 4, options) ==
+            json_utils::serialize_to_json(container, options));
+
+        REQUIRE(
+            json_utils::serialize_to_pretty_json_parallel(container, 4, options) ==
+            json_utils::serialize_to_pretty_json(container, options));
+
+        for (auto& member : container) {
+            member.second = nullptr;
+        }
+
+        REQUIRE(json_utils::serialize_to_json_parallel(container, 4, options) == "{}");
+        REQUIRE(json_utils::serialize_to_pretty_json_parallel(container, 4, options) == "{}");
+    }
+
+    SECTION("Small Containers Are Serialized on the Calling Thread")
+    {
+        const std::vector<int> container = { 1, 2, 3 };
+
+        REQUIRE(json_utils::serialize_to_json_parallel(container, 16) == "[1,2,3]");
+        REQUIRE(json_utils::serialize_to_json_parallel(std::vector<int>{}, 16) == "[]");
+    }
+
+    SECTION("Exceptions Are Propagated to the Caller")
+    {
+        const std::vector<sample::faulty_widget> container(10'000);
+
+        REQUIRE_THROWS_AS(
+            json_utils::serialize_to_json_parallel(container, 4), std::runtime_error);
+    }
+}
+
+#if __cplusplus >= 201703L // C++17
+
+TEST_CASE("Serializer Sessions")
+{
+    SECTION("Consecutive Messages are Independent")
+    {
+        json_utils::serializer_session<> session;
+
+        const std::vector<int> first = { 1, 2, 3 };
+        REQUIRE(session.serialize(first) == "[1,2,3]");
+
+        const std::map<std::string, int> second = { { "key", 42 } };
+        REQUIRE(session.serialize(second) == R"({"key":42})");
+
+        REQUIRE(session.view() == R"({"key":42})");
+    }
+
+    SECTION("Pretty Session Matches Pretty Serialization")
+    {
+        json_utils::pretty_serializer_session<> session;
+
+        const std::map<std::string, std::vector<int>> container = { { "Key", { 1, 2 } } };
+
+        REQUIRE(session.serialize(container) == json_utils::serialize_to_pretty_json(container));
+        REQUIRE(session.serialize(container) == json_utils::serialize_to_pretty_json(container));
+    }
+
+    SECTION("Wide Output")
+    {
+        json_utils::serializer_session<rapidjson::UTF8<>, rapidjson::UTF16<>> session;
+
+        const std::vector<std::string> container = { "Hello", "World" };
+        REQUIRE(session.serialize(container) == L"[\"Hello\",\"World\"]");
+    }
+
+    SECTION("Resetting Discards Previous Output")
+    {
+        json_utils::serializer_session<> session{ 1024 };
+
+        const std::vector<bool> container = { true, false };
+        REQUIRE(session.serialize(container) == "[true,false]");
+
+        session.reset();
+        REQUIRE(session.view().empty());
+    }
+}
+
+TEST_CASE("Serialization of C++17 Constructs")
+{
+    SECTION("Array of std::string_view")
+    {
+        constexpr std::string_view hello = "Hello";
+        constexpr std::string_view world = "World";
+
+        const std::vector<std::string_view> container = { hello, world };
+        const auto json = json_utils::serialize_to_json(container);
+
+        REQUIRE(json == R"(["Hello","World"])");
+    }
+
+    SECTION("Array of std::optional<...> without Nulls")
+    {
+        const std::vector<std::optional<int>> container = { std::optional<int>{ 101 },
+                                                            std::optional<int>{ 202 } };
+
+        const auto json = json_utils::serialize_to_json(container);
+
+        REQUIRE(json == R"([101,202])");
+    }
+
+    SECTION("Array of std::optional<...> with Nulls")
+    {
+        const std::vector<std::optional<int>> container = { std::optional<int>{ 101 }, std::nullopt,
+                                                            std::nullopt,
+                                                            std::optional<int>{ 202 } };
+
+        const auto json = json_utils::serialize_to_json(container);
+
+        REQUIRE(json == R"([101,null,null,202])");
+    }
+}
+
+#endif
+
+TEST_CASE("Handling Pointer Types")
+{
+    SECTION("Using std::unique_ptr<...>")
+    {
+        auto container = std::vector<std::unique_ptr<std::string>>();
+        container.emplace_back(std::make_unique<std::string>("Hello"));
+        container.emplace_back(std::make_unique<std::string>("World"));
+
+        const auto json = json_utils::serialize_to_json(container);
+
+        REQUIRE(json == R"(["Hello","World"])");
+    }
+
+    SECTION("Using std::unique_ptr<...> Set to Null")
+    {
+        auto container = std::vector<std::unique_ptr<std::string>>();
+        container.emplace_back(std::make_unique<std::string>("Test"));
+        container.emplace_back(nullptr);
+
+        const auto json = json_utils::serialize_to_json(container);
+
+        REQUIRE(json == R"(["Test",null])");
+    }
+
+    SECTION("Using std::shared_ptr<...>")
+    {
+        const auto container =
+            std::vector<std::shared_ptr<std::string>>{ std::make_shared<std::string>("Hello"),
+                                                       std::make_shared<std::string>("World") };
+
+        const auto json = json_utils::serialize_to_json(container);
+
+        REQUIRE(json == R"(["Hello","World"])");
+    }
+
+    SECTION("Using std::shared_ptr<...> Set to Null")
+    {
+        const auto container =
+            std::vector<std::shared_ptr<std::string>>{ std::make_shared<std::string>("Test"),
+                                                       nullptr };
+
+        const auto json = json_utils::serialize_to_json(container);
+
+        REQUIRE(json == R"(["Test",null])");
+    }
+
+    SECTION("Using std::weak_ptr<...>")
+    {
+        const auto pointer_one = std::make_shared<std::string>("Hello");
+        const auto pointer_two = std::make_shared<std::string>("World");
+
+        const auto container = std::vector<std::weak_ptr<std::string>>{ pointer_one, pointer_two };
+
+        const auto json = json_utils::serialize_to_json(container);
+
+        REQUIRE(json == R"(["Hello","World"])");
+    }
+
+    SECTION("Using std::weak_ptr<...> Set to Null")
+    {
+        const auto pointer_one = std::make_shared<std::string>("Test");
+
+        const auto container = std::vector<std::weak_ptr<std::string>>{
+            pointer_one, std::make_shared<std::string>("Short lived temporary")
+        };
+
+        const auto json = json_utils::serialize_to_json(container);
+
+        REQUIRE(json == R"(["Test",null])");
+    }
+}
+
+TEST_CASE("Shared Pointer Memoization")
+{
+    const auto leaf = std::make_shared<sample::graph_node>(sample::graph_node{ "leaf", {} });
+    const auto branch =
+        std::make_shared<sample::graph_node>(sample::graph_node{ "branch", { leaf, leaf } });
+
+    const std::vector<std::shared_ptr<sample::graph_node>> graph{ branch, leaf, nullptr };
+
+    json_utils::serialization_options options;
+
+    SECTION("Memoized Objects Are Written Out in Full Every Time")
+    {
+        options.shared_pointers = json_utils::shared_pointer_policy::memoize;
+
+        const auto expected = json_utils::serialize_to_json(graph);
+        const auto json = json_utils::serialize_to_json(graph, options);
+
+        REQUIRE(json == expected);
+    }
+
+    SECTION("Shared Objects Are Written Once, and Referred to Thereafter")
+    {
+        options.shared_pointers = json_utils::shared_pointer_policy::reference;
+
+        const auto json = json_utils::serialize_to_json(graph, options);
+
+        REQUIRE(
+            json == R"([{"$id":1,"name":"branch","edges":[{"$id":2,"name":"leaf","edges":[]},)"
+                    R"({"$ref":2}]},{"$ref":2},null])");
+    }
+
+    SECTION("Cycles Resolve to References")
+    {
+        options.shared_pointers = json_utils::shared_pointer_policy::reference;
+
+        leaf->edges.push_back(branch);
+        const auto json = json_utils::serialize_to_json(branch, options);
+        leaf->edges.clear();
+
+        REQUIRE(
+            json == R"({"$id":1,"name":"branch","edges":[{"$id":2,"name":"leaf","edges":)"
+                    R"([{"$ref":1}]},{"$ref":2}]})");
+    }
+
+    SECTION("Values That Aren't Objects Are Repeated")
+    {
+        options.shared_pointers = json_utils::shared_pointer_policy::reference;
+
+        const auto greeting = std::make_shared<std::string>("Hello");
+        const std::vector<std::shared_ptr<std::string>> greetings{ greeting, greeting };
+
+        const auto json = json_utils::serialize_to_json(greetings, options);
+
+        REQUIRE(json == R"(["Hello","Hello"])");
+    }
+
+    SECTION("Weak Pointers Refer to the Same Objects")
+    {
+        options.shared_pointers = json_utils::shared_pointer_policy::reference;
+
+        const std::vector<std::weak_ptr<sample::graph_node>> observers{ leaf, leaf };
+
+        const auto json = json_utils::serialize_to_json(observers, options);
+
+        REQUIRE(json == R"([{"$id":1,"name":"leaf","edges":[]},{"$ref":1}])");
+    }
+
+    SECTION("Identifiers Restart with Every Call")
+    {
+        options.shared_pointers = json_utils::shared_pointer_policy::reference;
+
+        const auto first = json_utils::serialize_to_json(graph, options);
+        const auto second = json_utils::serialize_to_json(graph, options);
+
+        REQUIRE(second == first);
+    }
+
+    SECTION("Deep Chains of Shared Objects Are Memoized")
+    {
+        options.shared_pointers = json_utils::shared_pointer_policy::memoize;
+
+        std::vector<std::shared_ptr<sample::graph_node>> chain;
+        for (int index = 0; index < 200; ++index) {
+            auto node = std::make_shared<sample::graph_node>(
+                sample::graph_node{ std::to_string(index), {} });
+
+            if (!chain.empty()) {
+                node->edges.push_back(chain.back());
+            }
+
+            chain.push_back(std::move(node));
+        }
+
+        const std::vector<std::shared_ptr<sample::graph_node>> ends{ chain.back(), chain[100] };
+        const auto expected = json_utils::serialize_to_json(ends);
+        const auto json = json_utils::serialize_to_json(ends, options);
+
+        REQUIRE(json == expected);
+
+        // Streams that don't retain their output are replayed from the memo instead.
+        rapidjson::StringBuffer buffer;
+        json_utils::writer<rapidjson::StringBuffer> writer{ buffer };
+        writer.set_options(options);
+
+        json_utils::serializer::to_json(writer, ends);
+
+        REQUIRE(std::string{ buffer.GetString() } == expected);
+    }
+
+    SECTION("Pretty Writers Refer to Shared Objects")
+    {
+        options.shared_pointers = json_utils::shared_pointer_policy::reference;
+
+        json_utils::string_output_stream<> stream;
+        json_utils::pretty_writer<json_utils::string_output_stream<>> writer{ stream };
+        writer.set_options(options);
+
+        leaf->edges.push_back(branch);
+        json_utils::serializer::to_json(writer, branch);
+        leaf->edges.clear();
+
+        const auto expected = R"({
+    "$id": 1,
+    "name": "branch",
+    "edges": [
+        {
+            "$id": 2,
+            "name": "leaf",
+            "edges": [
+                {
+                    "$ref": 1
+                }
+            ]
+        },
+        {
+            "$ref": 2
+        }
+    ]
+})";
+
+        REQUIRE(stream.str() == expected);
+    }
+}
+
+TEST_CASE("Serializations of Composite Containers")
+{
+    SECTION("std::map<std::string, std::vector<std::shared_ptr<std::string>>>")
+    {
+        const std::map<std::string, std::vector<std::shared_ptr<std::string>>> container = {
+            { "Key One",
+              std::vector<std::shared_ptr<std::string>>{
+                  std::make_shared<std::string>("Value 1.A"),
+                  std::make_shared<std::string>("Value 1.B"),
+                  std::make_shared<std::string>("Value 1.C") } },
+            { "Key Two",
+              std::vector<std::shared_ptr<std::string>>{
+                  std::make_shared<std::string>("Value 2.A"),
+                  std::make_shared<std::string>("Value 2.B") } }
+        };
+
+        const auto json = json_utils::serialize_to_json(container);
+
+        REQUIRE(
+            json ==
+            R"({"Key One":["Value 1.A","Value 1.B","Value 1.C"],"Key Two":["Value 2.A","Value 2.B"]})");
+    }
+
+    SECTION("std::map<std::string, std::map<std::string, double>>")
+    {
+        const std::map<std::string, std::map<std::string, double>> container = {
+            { "Key One", std::map<std::string, double>{ { "Subkey One", 16.0 },
+                                                        { "Subkey Two", 32.0 },
+                                                        { "Subkey Three", 64.0 } } },
+            { "Key Two", std::map<std::string, double>{ { "Subkey One", 128.0 },
+                                                        { "Subkey Two", 256.0 },
+                                                        { "Subkey Three", 512.0 } } }
+        };
+
+        const auto json = json_utils::serialize_to_json(container);
+
+        REQUIRE(
+            json == R"({)"
+                    R"("Key One":{"Subkey One":16.0,"Subkey Three":64.0,"Subkey Two":32.0},)"
+                    R"("Key Two":{"Subkey One":128.0,"Subkey Three":512.0,"Subkey Two":256.0})"
+                    R"(})");
+    }
+
+    SECTION("With a More Complex, Nested Type")
+    {
+        const std::vector<std::pair<std::string, std::map<std::string, double>>> container = {
+            { "Key One", std::map<std::string, double>{ { "Subkey One", 16.0 },
+                                                        { "Subkey Two", 32.0 },
+                                                        { "Subkey Three", 64.0 } } },
+            { "Key Two", std::map<std::string, double>{ { "Subkey One", 128.0 },
+                                                        { "Subkey Two", 256.0 },
+                                                        { "Subkey Three", 512.0 } } }
+        };
+
+        const auto json = json_utils::serialize_to_pretty_json(container);
+
+        REQUIRE(
+            json ==
+            "{\n"
+            "    \"Key One\": {\n"
+            "        \"Subkey One\": 16.0,\n"
+            "        \"Subkey Three\": 64.0,\n"
+            "        \"Subkey Two\": 32.0\n"
+            "    },\n"
+            "    \"Key Two\": {\n"
+            "        \"Subkey One\": 128.0,\n"
+            "        \"Subkey Three\": 512.0,\n"
+            "        \"Subkey Two\": 256.0\n"
+            "    }\n"
+            "}");
+    }
+}
+
+TEST_CASE("Serialization of Ranges and Generators")
+{
+    const std::vector<int> numbers = { 1, 2, 3, 4, 5 };
+
+    SECTION("Iterator Pairs as Arrays")
+    {
+        const auto json = json_utils::serialize_to_json(
+            json_utils::as_array(std::next(numbers.begin()), std::prev(numbers.end())));
+
+        REQUIRE(json == "[2,3,4]");
+    }
+
+    SECTION("Iterators with Sentinels as Arrays")
+    {
+        const int values[] = { 7, 8, 9, 0, 10 };
+        const auto json =
+            json_utils::serialize_to_json(json_utils::as_array(&values[0], zero_sentinel{}));
+
+        REQUIRE(json == "[7,8,9]");
+    }
+
+    SECTION("Views That Are Only Iterable When Not Const")
+    {
+        const auto json = json_utils::serialize_to_json(
+            json_utils::as_array(even_numbers_view{ { 1, 2, 3, 4, 5, 6 } }));
+
+        REQUIRE(json == "[2,4,6]");
+    }
+
+    SECTION("Ranges of Pairs as Objects")
+    {
+        const std::list<std::pair<std::string, int>> pairs = { { "b", 2 }, { "a", 1 } };
+        const auto json = json_utils::serialize_to_json(json_utils::as_object(pairs));
+
+        REQUIRE(json == R"({"b":2,"a":1})");
+    }
+
+    SECTION("Projected Ranges as Objects")
+    {
+        const auto json = json_utils::serialize_to_json(json_utils::as_object(
+            numbers.begin(), numbers.begin() + 2,
+            [](int number) { return "key" + std::to_string(number); },
+            [](int number) { return std::vector<int>(static_cast<std::size_t>(number), 0); }));
+
+        REQUIRE(json == R"({"key1":[0],"key2":[0,0]})");
+    }
+
+    SECTION("Generated Arrays")
+    {
+        const auto generator = [&](auto&& emit) {
+            for (const auto number : numbers) {
+                if (number > 3) {
+                    emit(number);
+                }
+            }
+
+            emit(std::string{ "end" });
+        };
+
+        const auto json = json_utils::serialize_to_json(json_utils::generate_array(generator));
+
+        REQUIRE(json == R"([4,5,"end"])");
+    }
+
+    SECTION("Generated Objects")
+    {
+        const auto json =
+            json_utils::serialize_to_json(json_utils::generate_object([&](auto&& emit) {
+                emit(std::string{ "total" }, std::accumulate(numbers.begin(), numbers.end(), 0));
+                emit(std::string{ "nested" }, json_utils::as_array(numbers.begin(), numbers.end()));
+            }));
+
+        REQUIRE(json == R"({"total":15,"nested":[1,2,3,4,5]})");
+    }
+
+    SECTION("Empty Ranges")
+    {
+        const std::vector<int> empty;
+
+        const auto key = [](int) { return std::string{}; };
+        const auto value = [](int) { return 0; };
+
+        REQUIRE(json_utils::serialize_to_json(json_utils::as_array(empty)) == "[]");
+        REQUIRE(json_utils::serialize_to_json(json_utils::as_object(empty, key, value)) == "{}");
+    }
+}
+
+TEST_CASE("Columnar Serialization")
+{
+    SECTION("Maps with Identical Keys")
+    {
+        const std::vector<std::map<std::string, int>> records = { { { "a", 1 }, { "b", 2 } },
+                                                                  { { "a", 3 }, { "b", 4 } },
+                                                                  { { "a", 5 }, { "b", 6 } } };
+
+        const auto json = json_utils::serialize_to_json(json_utils::as_columns(records));
+
+        REQUIRE(json == R"({"a":[1,3,5],"b":[2,4,6]})");
+    }
+
+    SECTION("Unordered Maps with Identical Keys")
+    {
+        const std::vector<std::unordered_map<int, std::string>> records = {
+            { { 1, "x" }, { 2, "y" }, { 3, "z" } }, { { 3, "c" }, { 1, "a" }, { 2, "b" } }
+        };
+
+        const auto json = json_utils::serialize_to_json(json_utils::as_columns(records));
+        const auto columns = json_utils::deserialize_via_dom<
+            std::map<int, std::vector<std::string>>>(json);
+
+        REQUIRE(columns.at(1) == std::vector<std::string>{ "x", "a" });
+        REQUIRE(columns.at(2) == std::vector<std::string>{ "y", "b" });
+        REQUIRE(columns.at(3) == std::vector<std::string>{ "z", "c" });
+    }
+
+    SECTION("Maps with Different Keys Are Rejected")
+    {
+        const std::vector<std::map<std::string, int>> missing_key = { { { "a", 1 }, { "b", 2 } },
+                                                                      { { "a", 3 } } };
+
+        const std::vector<std::map<std::string, int>> extra_key = { { { "a", 1 } },
+                                                                    { { "a", 3 }, { "b", 4 } } };
+
+        REQUIRE_THROWS_AS(
+            json_utils::serialize_to_json(json_utils::as_columns(missing_key)),
+            std::invalid_argument);
+
+        REQUIRE_THROWS_AS(
+            json_utils::serialize_to_json(json_utils::as_columns(extra_key)),
+            std::invalid_argument);
+
+        const std::vector<std::map<std::string, int>> empty_first = { {}, { { "a", 1 } } };
+
+        REQUIRE_THROWS_AS(
+            json_utils::serialize_to_json(json_utils::as_columns(empty_first)),
+            std::invalid_argument);
+    }
+
+    SECTION("Records with a Registered Layout")
+    {
+        const std::vector<sample::sensor_reading> readings = { { "t1", 1.5, true },
+                                                               { "t2", 2.0, false } };
+
+        const auto json = json_utils::serialize_to_json(json_utils::as_columns(readings));
+
+        REQUIRE(json == R"({"sensor":["t1","t2"],"value":[1.5,2.0],"scaled":[15.0,20.0]})");
+    }
+
+    SECTION("Empty Ranges")
+    {
+        const std::vector<std::map<std::string, int>> maps;
+        const std::list<sample::sensor_reading> readings;
+
+        REQUIRE(json_utils::serialize_to_json(json_utils::as_columns(maps)) == "{}");
+        REQUIRE(
+            json_utils::serialize_to_json(json_utils::as_columns(readings)) ==
+            R"({"sensor":[],"value":[],"scaled":[]})");
+    }
+
+    SECTION("Nested in Other Data")
+    {
+        const std::vector<std::map<std::string, int>> records = { { { "a", 1 } }, { { "a", 2 } } };
+        const auto json = json_utils::serialize_to_json(json_utils::generate_object(
+            [&](auto&& emit) { emit(std::string{ "table" }, json_utils::as_columns(records)); }));
+
+        REQUIRE(json == R"({"table":{"a":[1,2]}})");
+    }
+}
+
+TEST_CASE("Cached Fragments")
+{
+    using fragment_type = json_utils::cached_fragment<std::map<std::string, double>>;
+
+    json_utils::fragment_cache cache{ 1024 };
+
+    std::vector<fragment_type> catalog;
+    catalog.emplace_back(cache, std::map<std::string, double>{ { "price", 1.5 } });
+    catalog.emplace_back(cache, std::map<std::string, double>{ { "price", 2.5 } });
+
+    SECTION("Unchanged Fragments Are Spliced from the Cache")
+    {
+        const auto first = json_utils::serialize_to_json(catalog);
+        const auto second = json_utils::serialize_to_json(catalog);
+
+        REQUIRE(first == R"([{"price":1.5},{"price":2.5}])");
+        REQUIRE(second == first);
+        REQUIRE(cache.misses() == 2);
+        REQUIRE(cache.hits() == 2);
+        REQUIRE(cache.size() == first.size() - 3);
+    }
+
+    SECTION("Modified Fragments Are Serialized Again")
+    {
+        static_cast<void>(json_utils::serialize_to_json(catalog));
+
+        catalog[1].modify()["price"] = 3.0;
+        const auto json = json_utils::serialize_to_json(catalog);
+
+        REQUIRE(json == R"([{"price":1.5},{"price":3.0}])");
+        REQUIRE(cache.misses() == 3);
+        REQUIRE(cache.hits() == 1);
+    }
+
+    SECTION("Explicit Invalidation")
+    {
+        static_cast<void>(json_utils::serialize_to_json(catalog));
+
+        catalog[0].invalidate();
+        cache.invalidate(catalog[1].id());
+        static_cast<void>(json_utils::serialize_to_json(catalog));
+
+        REQUIRE(cache.misses() == 4);
+
+        cache.clear();
+
+        REQUIRE(cache.size() == 0);
+    }
+
+    SECTION("Fragments Survive Reallocation of Their Container")
+    {
+        static_cast<void>(json_utils::serialize_to_json(catalog));
+
+        catalog.reserve(catalog.capacity() * 4);
+        static_cast<void>(json_utils::serialize_to_json(catalog));
+
+        REQUIRE(cache.hits() == 2);
+    }
+
+    SECTION("The Least Recently Used Fragments Are Evicted")
+    {
+        json_utils::fragment_cache small_cache{ 40 };
+
+        std::vector<json_utils::cached_fragment<std::string>> strings;
+        for (int index = 0; index < 5; ++index) {
+            strings.emplace_back(small_cache, std::string(8, static_cast<char>('a' + index)));
+        }
+
+        strings.emplace_back(small_cache, std::string(100, 'z'));
+
+        const auto json = json_utils::serialize_to_json(strings);
+
+        REQUIRE(json == json_utils::serialize_to_json(std::vector<std::string>{
+                            "aaaaaaaa", "bbbbbbbb", "cccccccc", "dddddddd", "eeeeeeee",
+                            std::string(100, 'z') }));
+        REQUIRE(small_cache.size() <= small_cache.capacity());
+
+        static_cast<void>(json_utils::serialize_to_json(strings[4]));
+
+        REQUIRE(small_cache.hits() == 1);
+    }
+
+    SECTION("Different Number Formats Are Cached Separately")
+    {
+        json_utils::serialization_options options;
+        options.numbers = json_utils::number_format::fixed(2);
+
+        static_cast<void>(json_utils::serialize_to_json(catalog));
+        const auto json = json_utils::serialize_to_json(catalog, options);
+
+        REQUIRE(json == R"([{"price":1.50},{"price":2.50}])");
+        REQUIRE(cache.hits() == 0);
+    }
+
+    SECTION("Writers That Can't Splice JSON Serialize the Data")
+    {
+        std::vector<std::map<std::string, double>> plain;
+        for (const auto& fragment : catalog) {
+            plain.push_back(fragment.get());
+        }
+
+        REQUIRE(
+            json_utils::serialize_to_pretty_json(catalog) ==
+            json_utils::serialize_to_pretty_json(plain));
+
+        REQUIRE(
+            json_utils::serialize_to_msgpack(catalog) == json_utils::serialize_to_msgpack(plain));
+        REQUIRE(cache.hits() + cache.misses() == 0);
+    }
+
+    SECTION("Fragments Hash Like the Data They Wrap")
+    {
+        using map_type = std::unordered_map<std::string, int>;
+
+        map_type first;
+        map_type second{ 64 };
+
+        for (int index = 0; index < 16; ++index) {
+            first.emplace(std::to_string(index), index);
+            second.emplace(std::to_string(15 - index), 15 - index);
+        }
+
+        const json_utils::cached_fragment<map_type> fragment{ cache, first };
+
+        json_utils::hash_options options;
+        options.sort_keys = true;
+
+        REQUIRE(json_utils::content_hash(fragment) == json_utils::content_hash(first));
+        REQUIRE(
+            json_utils::content_hash(fragment, options) ==
+            json_utils::content_hash(second, options));
+        REQUIRE(cache.hits() + cache.misses() == 0);
+    }
+}
+
+TEST_CASE("Raw JSON Values")
+{
+    SECTION("Raw Values Are Spliced Verbatim")
+    {
+        std::map<std::string, json_utils::raw_json> response;
+        response.emplace("cached", json_utils::raw_json{ R"({"items":[1,2.50,"three"]})" });
+        response.emplace("missing", json_utils::raw_json{});
+
+        const std::vector<json_utils::raw_json> array = { json_utils::raw_json{ "true" },
+                                                          json_utils::raw_json{ "1e3" } };
+
+        REQUIRE(
+            json_utils::serialize_to_json(response) ==
+            R"({"cached":{"items":[1,2.50,"three"]},"missing":null})");
+
+        REQUIRE(json_utils::serialize_to_json(array) == R"([true,1e3])");
+    }
+
+    SECTION("Validation")
+    {
+        REQUIRE(json_utils::raw_json{ R"( {"a": [1, 2]} )" }.is_valid());
+        REQUIRE(json_utils::raw_json{ "\"text\"" }.is_valid());
+
+        REQUIRE_FALSE(json_utils::raw_json{ "" }.is_valid());
+        REQUIRE_FALSE(json_utils::raw_json{ "[1, 2" }.is_valid());
+        REQUIRE_FALSE(json_utils::raw_json{ "1 2" }.is_valid());
+        REQUIRE_FALSE(json_utils::raw_json{ std::string{ "[1]\0[2]", 7 } }.is_valid());
+
+        REQUIRE_NOTHROW(json_utils::raw_json::validated("[]"));
+        REQUIRE_THROWS_AS(json_utils::raw_json::validated("{\"a\"}"), std::invalid_argument);
+    }
+
+    SECTION("Pretty Writers Reformat Raw Values")
+    {
+        const std::vector<json_utils::raw_json> raw = { json_utils::raw_json{
+            R"({ "a" : [1,2] })" } };
+
+        const std::vector<std::map<std::string, std::vector<int>>> parsed = {
+            { { "a", { 1, 2 } } }
+        };
+
+        REQUIRE(
+            json_utils::serialize_to_pretty_json(raw) ==
+            json_utils::serialize_to_pretty_json(parsed));
+    }
+
+    SECTION("Binary Writers Receive the Parsed Values")
+    {
+        const std::map<std::string, json_utils::raw_json> raw = {
+            { "a", json_utils::raw_json{ R"([1,-2,"three",null])" } }
+        };
+
+        const std::vector<std::uint8_t> expected = { 0x81, 0xA1, 'a',  0x94, 0x01, 0xFE, 0xA5,
+                                                     't',  'h',  'r',  'e',  'e',  0xC0 };
+
+        REQUIRE(json_utils::serialize_to_msgpack(raw) == expected);
+    }
+
+    SECTION("Hash Writers Receive the Parsed Values")
+    {
+        const json_utils::raw_json compact{ R"({"a":1,"b":[true]})" };
+        const json_utils::raw_json spaced{ R"({ "a" : 1, "b" : [ true ] })" };
+        const json_utils::raw_json reordered{ R"({"b":[true],"a":1})" };
+
+        const std::map<std::string, json_utils::raw_json> nested = {
+            { "a", json_utils::raw_json{ "1" } }, { "b", json_utils::raw_json{ "[true]" } }
+        };
+
+        json_utils::hash_options options;
+        options.sort_keys = true;
+
+        REQUIRE(json_utils::content_hash(compact) == json_utils::content_hash(spaced));
+        REQUIRE(json_utils::content_hash(compact) == json_utils::content_hash(nested));
+        REQUIRE(json_utils::content_hash(compact) != json_utils::content_hash(reordered));
+        REQUIRE(
+            json_utils::content_hash(compact, options) ==
+            json_utils::content_hash(reordered, options));
+    }
+}
+
+TEST_CASE("Serializing a Custom Type")
+{
+    SECTION("Custom Type as Key")
+    {
+        const std::vector<std::pair<sample::simple_widget, std::list<std::shared_ptr<std::string>>>>
+            container = {
+                { sample::simple_widget{ "Widget One" },
+                  { std::make_unique<std::string>("1"), std::make_unique<std::string>("2"),
+                    std::make_unique<std::string>("3"), std::make_unique<std::string>("4"),
+                    std::make_unique<std::string>("5"), nullptr } },
+                { sample::simple_widget{ "Widget Two" },
+                  { std::make_unique<std::string>("5"), std::make_unique<std::string>("6"),
+                    std::make_unique<std::string>("7"), std::make_unique<std::string>("8"),
+                    std::make_unique<std::string>("9") } }
+            };
+
+        const auto json = json_utils::serialize_to_json(container);
+
+        REQUIRE(
+            json ==
+            R"({"Widget One":["1","2","3","4","5",null],"Widget Two":["5","6","7","8","9"]})");
+    }
+
+    SECTION("Custom Type with Nested Custom Type")
+    {
+        const std::vector<sample::composite_widget> container = { sample::composite_widget{
+            "JSON Serialization" } };
+
+        const auto json = json_utils::serialize_to_json(container);
+
+        REQUIRE(json == R"([{"Inner Widget":{"Purpose":"JSON Serialization"}}])");
+    }
+
+    SECTION("Custom Type as Value in std::vector<...>")
+    {
+        const std::vector<sample::simple_widget> container = { sample::simple_widget{
+            "JSON Serialization" } };
+
+        const auto json = json_utils::serialize_to_json(container);
+
+        REQUIRE(json == R"([{"Purpose":"JSON Serialization"}])");
+    }
+
+    SECTION("Custom Type as Value in std::vector<std::pair<...>>")
+    {
+        const std::vector<std::pair<std::string, sample::simple_widget>> container = {
+            std::make_pair<std::string, sample::simple_widget>(
+                "Widget", sample::simple_widget{ "JSON Serialization" })
+        };
+
+        const auto json = json_utils::serialize_to_json(container);
+
+        REQUIRE(json == R"({"Widget":{"Purpose":"JSON Serialization"}})");
+    }
+}
+
+TEST_CASE("Serialization of Keys")
+{
+    SECTION("Keys Containing Characters that Require Escaping")
+    {
+        const std::map<std::string, int> container = { { std::string{ "a\0b", 3 }, 1 },
+                                                       { "quote\"d", 2 } };
+
+        const auto json = json_utils::serialize_to_json(container);
+
+        REQUIRE(json == R"({"a\u0000b":1,"quote\"d":2})");
+    }
+
+    SECTION("Custom Key Type Formatted into a Key Buffer")
+    {
+        const std::map<sample::coordinate, int> container = { { { 1, 2 }, 3 }, { { 4, 5 }, 6 } };
+
+        const auto json = json_utils::serialize_to_json(container);
+
+        REQUIRE(json == R"({"1,2":3,"4,5":6})");
+    }
+
+    SECTION("Integral Keys")
+    {
+        const std::map<std::int64_t, int> signed_keys = { { -9223372036854775807 - 1, 1 },
+                                                          { 0, 2 },
+                                                          { 42, 3 } };
+
+        REQUIRE(
+            json_utils::serialize_to_json(signed_keys) ==
+            R"({"-9223372036854775808":1,"0":2,"42":3})");
+
+        const std::map<std::uint64_t, int> unsigned_keys = { { 18446744073709551615u, 1 } };
+        REQUIRE(json_utils::serialize_to_json(unsigned_keys) == R"({"18446744073709551615":1})");
+
+        const std::unordered_map<short, int> short_keys = { { -7, 1 } };
+        REQUIRE(json_utils::serialize_to_json(short_keys) == R"({"-7":1})");
+    }
+
+    SECTION("Enumeration Keys")
+    {
+        const std::map<sample::color, int> container = { { sample::color::red, 1 },
+                                                          { sample::color::blue, 2 } };
+
+        REQUIRE(json_utils::serialize_to_json(container) == R"({"0":1,"2":2})");
+    }
+
+    SECTION("Enumeration Keys with a Key Conversion")
+    {
+        const std::map<sample::unit, int> container = { { sample::unit::celsius, 1 },
+                                                         { sample::unit::kelvin, 2 } };
+
+        REQUIRE(json_utils::serialize_to_json(container) == R"({"celsius":1,"kelvin":2})");
+    }
+
+    SECTION("Integral Keys Written by Wide Writers")
+    {
+        const std::map<int, int> container = { { -12, 1 } };
+
+        const auto json =
+            json_utils::serialize_to_json<rapidjson::UTF16<>, rapidjson::UTF16<>>(container);
+
+        REQUIRE(json == LR"({"-12":1})");
+    }
+
+    SECTION("Key Buffer Rejects Oversized Keys")
+    {
+        json_utils::serializer::key_buffer<char> buffer;
+        const std::string oversized_key(200, 'x');
+
+        REQUIRE_THROWS_AS(
+            buffer.append(oversized_key.data(), oversized_key.size()), std::length_error);
+    }
+}
+
+TEST_CASE("Size-Reducing Output Options")
+{
+    json_utils::serialization_options options;
+
+    SECTION("Omitting Null Members")
+    {
+        options.omit_null_members = true;
+
+        const std::map<std::string, std::shared_ptr<int>> map = {
+            { "Present", std::make_shared<int>(0) }, { "Absent", nullptr }
+        };
+
+        const std::vector<std::shared_ptr<int>> vector = { nullptr, std::make_shared<int>(1) };
+
+        REQUIRE(json_utils::serialize_to_json(map, options) == R"({"Present":0})");
+        REQUIRE(json_utils::serialize_to_json(vector, options) == R"([null,1])");
+    }
+
+    SECTION("Omitting Default Members")
+    {
+        options.omit_default_members = true;
+
+        const std::map<std::string, int> numbers = { { "Zero", 0 }, { "One", 1 } };
+        const std::map<std::string, std::string> strings = { { "Empty", "" }, { "Text", "A" } };
+        const std::map<std::string, std::vector<int>> vectors = { { "Empty", {} },
+                                                                  { "Full", { 0 } } };
+
+        REQUIRE(json_utils::serialize_to_json(numbers, options) == R"({"One":1})");
+        REQUIRE(json_utils::serialize_to_json(strings, options) == R"({"Text":"A"})");
+        REQUIRE(json_utils::serialize_to_json(vectors, options) == R"({"Full":[0]})");
+    }
+
+#if __cplusplus >= 201703L // C++17
+
+    SECTION("Omitting Empty Optionals")
+    {
+        options.omit_null_members = true;
+
+        const std::map<std::string, std::optional<int>> map = { { "Empty", std::nullopt },
+                                                                { "Zero", 0 } };
+
+        REQUIRE(json_utils::serialize_to_json(map, options) == R"({"Zero":0})");
+    }
+
+#endif
+
+    SECTION("Omitting Members of Generated Objects")
+    {
+        options.omit_null_members = true;
+
+        const auto object = json_utils::generate_object([](auto&& emit) {
+            emit("First", std::unique_ptr<int>{});
+            emit("Second", std::make_unique<int>(2));
+            emit("Third", static_cast<const char*>(nullptr));
+        });
+
+        REQUIRE(json_utils::serialize_to_json(object, options) == R"({"Second":2})");
+    }
+
+    SECTION("Aliasing Keys")
+    {
+        const json_utils::key_alias_table aliases{ { "temperature", "t" },
+                                                   { "timestamp", "ts" } };
+        options.key_aliases = &aliases;
+
+        const std::map<std::string, int> map = { { "temperature", 20 },
+                                                 { "timestamp", 1000 },
+                                                 { "unit", 1 } };
+
+        REQUIRE(json_utils::serialize_to_json(map, options) == R"({"t":20,"ts":1000,"unit":1})");
+        REQUIRE(aliases.find("temp", 4) == nullptr);
+    }
+
+    SECTION("Aliasing Column Names")
+    {
+        const json_utils::key_alias_table aliases{ { "sensor", "s" }, { "scaled", "x" } };
+        options.key_aliases = &aliases;
+
+        const std::vector<sample::sensor_reading> readings = { { "t1", 1.5, true } };
+
+        REQUIRE(
+            json_utils::serialize_to_json(json_utils::as_columns(readings), options) ==
+            R"({"s":["t1"],"value":[1.5],"x":[15.0]})");
+    }
+
+    SECTION("Aliases Can Be Replaced")
+    {
+        json_utils::key_alias_table aliases;
+        aliases.add("name", "n");
+        aliases.add("name", "nm");
+
+        REQUIRE(*aliases.find("name", 4) == "nm");
+    }
+
+    SECTION("Resumable Serialization Applies the Same Options")
+    {
+        const json_utils::key_alias_table aliases{ { "Second", "2" } };
+
+        options.omit_default_members = true;
+        options.key_aliases = &aliases;
+
+        const std::map<std::string, std::vector<int>> map = {
+            { "First", {} }, { "Second", { 1, 2 } }, { "Third", {} }
+        };
+
+        json_utils::resumable_serializer<> serializer{ map, options };
+
+        std::string output;
+        char buffer[4];
+
+        for (auto result = serializer.produce(buffer, sizeof buffer);;
+             result = serializer.produce(buffer, sizeof buffer)) {
+            output.append(buffer, result.bytes_written);
+
+            if (result.done) {
+                break;
+            }
+        }
+
+        REQUIRE(output == R"({"2":[1,2]})");
+        REQUIRE(output == json_utils::serialize_to_json(map, options));
+    }
+}
+
+TEST_CASE("Serialization of Strings Requiring Escaping")
+{
+    const auto serialize_with_rapidjson = [](const std::string& data) {
+        rapidjson::StringBuffer buffer;
+        rapidjson::Writer<rapidjson::StringBuffer> writer{ buffer };
+        writer.String(data.data(), static_cast<rapidjson::SizeType>(data.size()));
+
+        return std::string{ buffer.GetString(), buffer.GetSize() };
+    };
+
+    SECTION("Output Matches rapidjson for Every Escape Position")
+    {
+        const std::string special_characters = { '"', '\\', '\b', '\f', '\n', '\r', '\t', '\x01',
+                                                 '\x1F', '\0', '/', '\x7F' };
+
+        for (const auto length : { 1, 15, 16, 17, 31, 32, 33, 63, 64, 65, 130 }) {
+            for (int position = 0; position < length; ++position) {
+                for (const auto character : special_characters) {
+                    std::string data(static_cast<std::size_t>(length), 'a');
+                    data[static_cast<std::size_t>(position)] = character;
+
+                    REQUIRE(json_utils::serialize_to_json(data) == serialize_with_rapidjson(data));
+                }
+            }
+        }
+    }
+
+    SECTION("Non-ASCII Characters Are Passed Through")
+    {
+        const std::string data = "Gr\xC3\xBC\xC3\x9F" "e, \xE4\xB8\x96\xE7\x95\x8C!\n";
+
+        REQUIRE(json_utils::serialize_to_json(data) == serialize_with_rapidjson(data));
+    }
+
+    SECTION("Pretty Writer Escapes Keys and Values")
+    {
+        const std::map<std::string, std::string> container = { { "tab\tkey", "line\nbreak" } };
+
+        const auto json = json_utils::serialize_to_pretty_json(container);
+
+        REQUIRE(json == "{\n    \"tab\\tkey\": \"line\\nbreak\"\n}");
+    }
+
+    SECTION("Trusted ASCII Strings Skip the Escape Scan")
+    {
+        const std::vector<json_utils::trusted_ascii> container = {
+            json_utils::trusted_ascii{ "alpha" }, json_utils::trusted_ascii{ "beta", 2 }
+        };
+
+        REQUIRE(json_utils::serialize_to_json(container) == R"(["alpha","be"])");
+        REQUIRE(
+            json_utils::serialize_to_pretty_json(container) ==
+            "[\n    \"alpha\",\n    \"be\"\n]");
+    }
+}
+
+TEST_CASE("Serialization of Floating-Point Numbers")
+{
+    SECTION("Doubles Use the Shortest Round-Trip Representation by Default")
+    {
+        const std::vector<double> container = { 0.1, 16.0, -2.25, 1e30 };
+
+        REQUIRE(json_utils::serialize_to_json(container) == "[0.1,16.0,-2.25,1e30]");
+    }
+
+    SECTION("Floats Are Not Promoted to Doubles")
+    {
+        const std::vector<float> container = { 0.1f, 3.3f, 16.0f, -2.25f };
+
+        REQUIRE(json_utils::serialize_to_json(container) == "[0.1,3.3,16.0,-2.25]");
+    }
+
+    // Without floating-point `std::to_chars(...)` (e.g., on GCC 9), the shortest digits of a
+    // `float` are found through `snprintf(...)` instead, so these cases exercise that fallback.
+    SECTION("Floats Are Laid Out Like Doubles")
+    {
+        const std::vector<float> floats = { 100000.0f, 1e10f, 1e22f, 0.000001f, 1e-7f, -0.0f };
+        const std::vector<double> doubles = { 100000.0, 1e10, 1e22, 0.000001, 1e-7, -0.0 };
+
+        const auto expected = "[100000.0,10000000000.0,1e22,0.000001,1e-7,-0.0]";
+
+        REQUIRE(json_utils::serialize_to_json(floats) == expected);
+        REQUIRE(json_utils::serialize_to_json(doubles) == expected);
+    }
+
+    SECTION("Fixed Number of Decimal Places")
+    {
+        const std::vector<double> doubles = { 1.0, 2.3456, -0.5 };
+        const std::vector<float> floats = { 0.1f };
+
+        const json_utils::serialization_options options{ json_utils::number_format::fixed(2) };
+
+        REQUIRE(json_utils::serialize_to_json(doubles, options) == "[1.00,2.35,-0.50]");
+        REQUIRE(json_utils::serialize_to_json(floats, options) == "[0.10]");
+    }
+
+    SECTION("Maximum Number of Decimal Places")
+    {
+        const std::vector<double> doubles = { 1.23456, 0.000012, 2.5 };
+        const std::vector<float> floats = { 0.1f, 1.23456f };
+
+        const json_utils::serialization_options options{
+            json_utils::number_format::max_decimal_places(3)
+        };
+
+        REQUIRE(json_utils::serialize_to_json(doubles, options) == "[1.234,0.0,2.5]");
+        REQUIRE(json_utils::serialize_to_json(floats, options) == "[0.1,1.234]");
+    }
+
+    SECTION("Pretty Writer Honours the Number Format")
+    {
+        const std::map<std::string, double> container = { { "pi", 3.14159 } };
+
+        const json_utils::serialization_options options{ json_utils::number_format::fixed(1) };
+
+        REQUIRE(
+            json_utils::serialize_to_pretty_json(container, options) == "{\n    \"pi\": 3.1\n}");
+    }
+
+    SECTION("Invalid Precision Is Rejected")
+    {
+        REQUIRE_THROWS_AS(json_utils::number_format::fixed(-1), std::invalid_argument);
+        REQUIRE_THROWS_AS(json_utils::number_format::fixed(18), std::invalid_argument);
+        REQUIRE_THROWS_AS(json_utils::number_format::max_decimal_places(0), std::invalid_argument);
+    }
+}
+
+TEST_CASE("Serialization to MessagePack")
+{
+    using bytes = std::vector<std::uint8_t>;
+
+    const auto append_string = [](bytes& output, const std::string& text) {
+        output.push_back(static_cast<std::uint8_t>(0xA0 | text.size()));
+        output.insert(std::end(output), std::begin(text), std::end(text));
+    };
+
+    SECTION("Integers Use the Smallest Representation")
+    {
+        const std::vector<std::int64_t> container = { 1, -1, 200, -200, 70'000, -5'000'000'000 };
+
+        const auto output = json_utils::serialize_to_msgpack(container);
+
+        REQUIRE(
+            output == bytes{ 0x96, 0x01, 0xFF, 0xCC, 0xC8, 0xD1, 0xFF, 0x38, 0xCE, 0x00,
+                             0x01, 0x11, 0x70, 0xD3, 0xFF, 0xFF, 0xFF, 0xFE, 0xD5, 0xFA,
+                             0x0E, 0x00 });
+    }
+
+    SECTION("Unsigned Integers")
+    {
+        const std::vector<std::uint64_t> container = { 127, 65'535,
+                                                       std::numeric_limits<std::uint64_t>::max() };
+
+        const auto output = json_utils::serialize_to_msgpack(container);
+
+        REQUIRE(
+            output == bytes{ 0x93, 0x7F, 0xCD, 0xFF, 0xFF, 0xCF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+                             0xFF, 0xFF, 0xFF });
+    }
+
+    SECTION("Floating-Point Numbers")
+    {
+        REQUIRE(
+            json_utils::serialize_to_msgpack(1.5) ==
+            bytes{ 0xCB, 0x3F, 0xF8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 });
+        REQUIRE(json_utils::serialize_to_msgpack(1.5f) == bytes{ 0xCA, 0x3F, 0xC0, 0x00, 0x00 });
+    }
+
+    SECTION("Nulls, Booleans, and Nested Containers")
+    {
+        const std::map<std::string, std::vector<std::shared_ptr<bool>>> container = {
+            { "a", { std::make_shared<bool>(true), nullptr } }, { "b", {} }
+        };
+
+        const auto output = json_utils::serialize_to_msgpack(container);
+
+        REQUIRE(output == bytes{ 0x82, 0xA1, 'a', 0x92, 0xC3, 0xC0, 0xA1, 'b', 0x90 });
+    }
+
+    SECTION("Long Strings and Containers")
+    {
+        const std::vector<std::string> container(20, std::string(40, 'x'));
+
+        const auto output = json_utils::serialize_to_msgpack(container);
+
+        REQUIRE(output.size() == 3 + 20 * (2 + 40));
+        REQUIRE(output[0] == 0xDC);
+        REQUIRE(output[1] == 0x00);
+        REQUIRE(output[2] == 20);
+        REQUIRE(output[3] == 0xD9);
+        REQUIRE(output[4] == 40);
+    }
+
+    SECTION("Custom Types Are Serialized through Their to_json Overloads")
+    {
+        const auto output = json_utils::serialize_to_msgpack(sample::heterogeneous_widget{});
+
+        bytes expected = { 0x82 };
+        append_string(expected, "Timestamp");
+        append_string(expected, "2019/05/29");
+        append_string(expected, "Data");
+        expected.push_back(0x93);
+        append_string(expected, "Test String One");
+        append_string(expected, "Test String Two");
+        append_string(expected, "Test String Three");
+
+        REQUIRE(output == expected);
+    }
+}
+
+TEST_CASE("Content Hashing")
+{
+    SECTION("XXH64 Reference Digests")
+    {
+        const auto digest_of = [](const std::string& input) {
+            json_utils::detail::xxh64 hash;
+            hash.update(input.data(), input.size());
+            return hash.digest();
+        };
+
+        REQUIRE(digest_of("") == 0xEF46DB3751D8E999ULL);
+        REQUIRE(digest_of("a") == 0xD24EC4F1A98C6E5BULL);
+        REQUIRE(digest_of("abc") == 0x44BC2CF5AD770999ULL);
+        REQUIRE(digest_of("Nobody inspects the spammish repetition") == 0xFBCEA83C8A378BF1ULL);
+    }
+
+    SECTION("XXH64 Digests Are Independent of How the Input Is Split")
+    {
+        std::string input(100, '\0');
+        std::iota(input.begin(), input.end(), '\0');
+
+        json_utils::detail::xxh64 whole;
+        whole.update(input.data(), input.size());
+
+        json_utils::detail::xxh64 pieces;
+        for (std::size_t offset = 0; offset < input.size(); offset += 7) {
+            pieces.update(input.data() + offset, std::min<std::size_t>(7, input.size() - offset));
+        }
+
+        REQUIRE(whole.digest() == pieces.digest());
+    }
+
+    SECTION("Equal Data Hashes Alike")
+    {
+        const std::map<std::string, std::vector<int>> data = { { "a", { 1, 2 } }, { "b", {} } };
+        const auto copy = data;
+
+        REQUIRE(json_utils::content_hash(data) == json_utils::content_hash(copy));
+        REQUIRE(
+            json_utils::content_hash(std::vector<int>{ 1, -2 }) ==
+            json_utils::content_hash(std::vector<std::int64_t>{ 1, -2 }));
+    }
+
+    SECTION("Different Data Hashes Differently")
+    {
+        const auto hash_of = [](const auto& data) { return json_utils::content_hash(data); };
+
+        REQUIRE(hash_of(std::vector<int>{ 1, 2 }) != hash_of(std::vector<int>{ 2, 1 }));
+        REQUIRE(
+            hash_of(std::vector<std::string>{ "ab", "c" }) !=
+            hash_of(std::vector<std::string>{ "a", "bc" }));
+        REQUIRE(hash_of(std::vector<double>{ 1.0 }) != hash_of(std::vector<int>{ 1 }));
+        REQUIRE(
+            hash_of(std::vector<std::vector<int>>{ { 1 }, {} }) !=
+            hash_of(std::vector<std::vector<int>>{ {}, { 1 } }));
+    }
+
+    SECTION("Sorted Keys Make Member Order Irrelevant")
+    {
+        using members_type = std::vector<std::pair<std::string, std::vector<int>>>;
+
+        const members_type forward = { { "a", { 1 } }, { "b", { 2 } }, { "c", {} } };
+        const members_type backward = { { "c", {} }, { "b", { 2 } }, { "a", { 1 } } };
+        const members_type different = { { "c", { 1 } }, { "b", { 2 } }, { "a", {} } };
+
+        json_utils::hash_options options;
+        options.sort_keys = true;
+
+        REQUIRE(json_utils::content_hash(forward) != json_utils::content_hash(backward));
+        REQUIRE(
+            json_utils::content_hash(forward, options) ==
+            json_utils::content_hash(backward, options));
+        REQUIRE(
+            json_utils::content_hash(forward, options) !=
+            json_utils::content_hash(different, options));
+    }
+
+    SECTION("Sorted Keys in Nested Unordered Maps")
+    {
+        std::unordered_map<std::string, std::unordered_map<int, std::string>> first;
+        std::unordered_map<std::string, std::unordered_map<int, std::string>> second{ 64 };
+
+        for (int index = 0; index < 32; ++index) {
+            first["outer" + std::to_string(index)][index] = std::to_string(index);
+            second["outer" + std::to_string(31 - index)][31 - index] = std::to_string(31 - index);
+        }
+
+        json_utils::hash_options options;
+        options.sort_keys = true;
 
-        REQUIRE(json == R"([{"Purpose":"JSON Serialization"}])");
+        REQUIRE(
+            json_utils::content_hash(first, options) == json_utils::content_hash(second, options));
     }
 
-    SECTION("Custom Type as Value in std::vector<std::pair<...>>")
+    SECTION("Seeds and Resets")
     {
-        const std::vector<std::pair<std::string, sample::simple_widget>> container = {
-            std::make_pair<std::string, sample::simple_widget>(
-                "Widget", sample::simple_widget{ "JSON Serialization" })
-        };
+        const std::vector<std::string> data = { "x", "y" };
 
-        const auto json = json_utils::serialize_to_json(container);
+        json_utils::hash_options options;
+        options.seed = 42;
 
-        REQUIRE(json == R"({"Widget":{"Purpose":"JSON Serialization"}})");
+        REQUIRE(json_utils::content_hash(data) != json_utils::content_hash(data, options));
+
+        json_utils::hash_writer writer{ options };
+        json_utils::serializer::to_json(writer, std::vector<int>{ 7 });
+        writer.Reset();
+        json_utils::serializer::to_json(writer, data);
+
+        REQUIRE(writer.digest() == json_utils::content_hash(data, options));
     }
 }
 
@@ -1050,6 +2931,75 @@ TEST_CASE("Deserialization into a std::map<...>")
     }
 }
 
+TEST_CASE("Deserialization into Maps with Non-String Keys")
+{
+    SECTION("Integral Keys")
+    {
+        using container_type = std::map<std::int64_t, std::vector<int>>;
+
+        const container_type source_container = { { -9223372036854775807 - 1, { 1 } },
+                                                  { 0, {} },
+                                                  { 9223372036854775807, { 2, 3 } } };
+
+        const auto json = json_utils::serialize_to_json(source_container);
+        const auto resultant_container = json_utils::deserialize_via_dom<container_type>(json);
+
+        REQUIRE(source_container == resultant_container);
+    }
+
+    SECTION("Unsigned Keys")
+    {
+        using container_type = std::unordered_map<std::uint16_t, std::string>;
+
+        const container_type source_container = { { 0, "zero" }, { 65535, "max" } };
+        const auto json = json_utils::serialize_to_json(source_container);
+        const auto resultant_container = json_utils::deserialize_via_dom<container_type>(json);
+
+        REQUIRE(source_container == resultant_container);
+    }
+
+    SECTION("Enumeration Keys")
+    {
+        using container_type = std::map<sample::color, int>;
+
+        const container_type source_container = { { sample::color::green, 1 } };
+        const auto json = json_utils::serialize_to_json(source_container);
+        const auto resultant_container = json_utils::deserialize_via_dom<container_type>(json);
+
+        REQUIRE(source_container == resultant_container);
+    }
+
+    SECTION("Wide Integral Keys")
+    {
+        using container_type = std::map<int, int>;
+
+        const auto resultant_container =
+            json_utils::deserialize_via_dom<container_type>(LR"({"-5":1,"7":2})");
+
+        REQUIRE(resultant_container == container_type{ { -5, 1 }, { 7, 2 } });
+    }
+
+    SECTION("Invalid Integral Keys")
+    {
+        using container_type = std::map<std::uint8_t, int>;
+
+        REQUIRE_THROWS_AS(
+            json_utils::deserialize_via_dom<container_type>(R"({"256":1})"),
+            std::invalid_argument);
+
+        REQUIRE_THROWS_AS(
+            json_utils::deserialize_via_dom<container_type>(R"({"-1":1})"),
+            std::invalid_argument);
+
+        REQUIRE_THROWS_AS(
+            json_utils::deserialize_via_dom<container_type>(R"({"":1})"), std::invalid_argument);
+
+        REQUIRE_THROWS_AS(
+            json_utils::deserialize_via_dom<container_type>(R"({"1a":1})"),
+            std::invalid_argument);
+    }
+}
+
 TEST_CASE("Deserialization into a std::map<std::string, std::vector<...>>")
 {
     SECTION("With a Single Entry")
@@ -1450,6 +3400,151 @@ TEST_CASE("To and From Files on Disk")
         REQUIRE(container == resultant_container);
     }
 
+    SECTION("JSON Lines Written to Disk")
+    {
+        {
+            json_utils::file_output_stream stream{ path, { 64 } };
+            json_utils::json_lines_writer<decltype(stream)> writer{ stream };
+
+            for (int index = 0; index < 100; ++index) {
+                writer.write(std::vector<int>{ index });
+            }
+
+            stream.close();
+        }
+
+        std::ifstream input{ path };
+        std::string line;
+        int index = 0;
+
+        while (std::getline(input, line)) {
+            REQUIRE(line == "[" + std::to_string(index++) + "]");
+        }
+
+        REQUIRE(index == 100);
+    }
+
+    SECTION("Uncompressed Files Are Read through the Compressed Path")
+    {
+        using container_type = std::vector<std::string>;
+
+        const container_type container = { "Plain", "Text" };
+        json_utils::serialize_to_json(container, path);
+
+        REQUIRE(
+            json_utils::deserialize_via_dom<container_type>(path, json_utils::compressed) ==
+            container);
+        REQUIRE(
+            json_utils::deserialize_via_sax<container_type>(path, json_utils::compressed) ==
+            container);
+    }
+
+    SECTION("Positions Remain Exact at the End of the Data")
+    {
+        {
+            std::ofstream output{ path, std::ios::binary };
+            output << "[1,2";
+        }
+
+        json_utils::compressed_input_stream stream{ path };
+        while (stream.Take() != '\0') {
+        }
+
+        REQUIRE(stream.Tell() == 4);
+        REQUIRE(stream.Peek() == '\0');
+        REQUIRE(stream.Tell() == 4);
+    }
+
+    SECTION("Unknown Compression Extension")
+    {
+        json_utils::serialize_to_json(std::vector<int>{ 0 }, path);
+
+        REQUIRE_THROWS_AS(
+            json_utils::serialize_to_json(
+                std::vector<int>{ 1 }, path, json_utils::compressed),
+            std::invalid_argument);
+
+        // The existing file must not be truncated before the codec is known.
+        REQUIRE(json_utils::deserialize_via_dom<std::vector<int>>(path) == std::vector<int>{ 0 });
+    }
+
+#ifdef JSON_UTILS_HAS_ZLIB
+    SECTION("Round-trip through gzip")
+    {
+        using container_type = std::map<std::string, std::vector<std::string>>;
+
+        container_type container;
+        for (int index = 0; index < 20'000; ++index) {
+            container["Key " + std::to_string(index)] = { std::to_string(index), "Payload" };
+        }
+
+        const auto gzip_path = std::filesystem::current_path() / "sample.json.gz";
+        json_utils::serialize_to_json(container, gzip_path, json_utils::compressed);
+
+        std::ifstream input{ gzip_path, std::ios::binary };
+        REQUIRE(input.get() == 0x1F);
+        REQUIRE(input.get() == 0x8B);
+        input.close();
+
+        const auto uncompressed_size = json_utils::serialize_to_json(container).size();
+        REQUIRE(std::filesystem::file_size(gzip_path) < uncompressed_size / 4);
+
+        REQUIRE(
+            json_utils::deserialize_via_dom<container_type>(gzip_path, json_utils::compressed) ==
+            container);
+        REQUIRE(
+            json_utils::deserialize_via_sax<container_type>(gzip_path, json_utils::compressed) ==
+            container);
+
+        std::filesystem::remove(gzip_path);
+    }
+
+    SECTION("Pretty Output with an Explicit Codec")
+    {
+        using container_type = std::vector<int>;
+
+        json_utils::compression_options options;
+        options.codec = json_utils::compression_codec::gzip;
+        options.level = 9;
+
+        const container_type container = { 1, 2, 3 };
+        json_utils::serialize_to_pretty_json(container, path, json_utils::compressed, options);
+
+        REQUIRE(
+            json_utils::deserialize_via_dom<container_type>(path, json_utils::compressed) ==
+            container);
+    }
+
+    SECTION("Corrupt gzip Data")
+    {
+        std::ofstream output{ path, std::ios::binary };
+        output << "\x1F\x8B\x08\x00corrupt";
+        output.close();
+
+        REQUIRE_THROWS_AS(
+            json_utils::deserialize_via_sax<std::vector<int>>(path, json_utils::compressed),
+            std::runtime_error);
+    }
+#endif
+
+#ifdef JSON_UTILS_HAS_ZSTD
+    SECTION("Round-trip through zstd")
+    {
+        using container_type = std::vector<std::string>;
+
+        const container_type container(100'000, "Payload");
+
+        const auto zstd_path = std::filesystem::current_path() / "sample.json.zst";
+        json_utils::serialize_to_json(container, zstd_path, json_utils::compressed);
+
+        REQUIRE(
+            json_utils::deserialize_via_sax<container_type>(zstd_path, json_utils::compressed) ==
+            container);
+
+        std::filesystem::remove(zstd_path);
+    }
+#endif
+
     SECTION("Round-trip to Disk")
     {
         using container_type = std::vector<std::string>;
@@ -1474,6 +3569,125 @@ TEST_CASE("To and From Files on Disk")
         REQUIRE(container == resultant_container);
     }
 
+    SECTION("Output Larger than the Write Buffer")
+    {
+        using container_type = std::vector<std::string>;
+
+        const container_type container(1'000, std::string(100, 'x'));
+
+        json_utils::file_write_options options;
+        options.buffer_size = 64;
+
+        json_utils::serialize_to_json(container, path, options);
+
+        const auto resultant_container = json_utils::deserialize_via_dom<container_type>(path);
+
+        REQUIRE(container == resultant_container);
+    }
+
+    SECTION("Synced, Atomic Replacement of an Existing File")
+    {
+        using container_type = std::vector<int>;
+
+        json_utils::serialize_to_json(container_type{ 1, 2, 3 }, path);
+
+        json_utils::file_write_options options;
+        options.sync = true;
+        options.atomic_replace = true;
+
+        const container_type container = { 4, 5, 6 };
+        json_utils::serialize_to_json(container, path, options);
+
+        const auto resultant_container = json_utils::deserialize_via_dom<container_type>(path);
+
+        REQUIRE(container == resultant_container);
+
+        const auto directory = std::filesystem::directory_iterator{ path.parent_path() };
+        const auto leftover_files = std::count_if(
+            begin(directory), end(directory), [&](const std::filesystem::directory_entry& entry) {
+                return entry.path().filename().string().rfind("sample.json.tmp", 0) == 0;
+            });
+
+        REQUIRE(leftover_files == 0);
+    }
+
+    SECTION("Abandoned Atomic Write Leaves the Target Untouched")
+    {
+        using container_type = std::vector<int>;
+
+        const container_type container = { 1, 2, 3 };
+        json_utils::serialize_to_json(container, path);
+
+        {
+            json_utils::file_write_options options;
+            options.atomic_replace = true;
+
+            json_utils::file_output_stream stream{ path, options };
+            stream.write("[4]", 3);
+        }
+
+        const auto resultant_container = json_utils::deserialize_via_dom<container_type>(path);
+
+        REQUIRE(container == resultant_container);
+    }
+
+    SECTION("Memory-mapped Round-trip to Disk")
+    {
+        using container_type = std::map<std::string, std::vector<std::string>>;
+
+        const container_type container = { { "Key", std::vector<std::string>(2'000, "Value") } };
+
+        json_utils::file_write_options options;
+        options.mmap_extent_size = 1;
+
+        json_utils::serialize_to_json(container, path, json_utils::mmap_output, options);
+
+        const auto resultant_container = json_utils::deserialize_via_dom<container_type>(path);
+
+        REQUIRE(container == resultant_container);
+        REQUIRE(
+            std::filesystem::file_size(path) == json_utils::serialize_to_json(container).size());
+    }
+
+    SECTION("Memory-mapped, Synced, Atomic Replacement of an Existing File")
+    {
+        using container_type = std::vector<int>;
+
+        json_utils::serialize_to_json(container_type{ 1, 2, 3 }, path);
+
+        json_utils::file_write_options options;
+        options.sync = true;
+        options.atomic_replace = true;
+
+        const container_type container = { 4, 5, 6 };
+        json_utils::serialize_to_pretty_json(container, path, json_utils::mmap_output, options);
+
+        const auto resultant_container = json_utils::deserialize_via_dom<container_type>(path);
+
+        REQUIRE(container == resultant_container);
+        REQUIRE(
+            std::filesystem::file_size(path) ==
+            json_utils::serialize_to_pretty_json(container).size());
+    }
+
+#ifdef JSON_UTILS_MEMORY_MAPPED_FILES
+    SECTION("Memory-mapped Output Falls Back for Files That Can't Be Mapped")
+    {
+        const std::vector<int> container = { 1 };
+
+        REQUIRE_NOTHROW(
+            json_utils::serialize_to_json(container, "/dev/null", json_utils::mmap_output));
+    }
+#endif
+
+    SECTION("Errors Are Reported")
+    {
+        const auto invalid_path = path / "missing-directory" / "sample.json";
+
+        REQUIRE_THROWS_AS(
+            json_utils::serialize_to_json(std::vector<int>{ 1 }, invalid_path), std::system_error);
+    }
+
     if (std::filesystem::exists(path)) {
         std::filesystem::remove(path);
     }
@@ -2351,6 +4565,144 @@ TEST_CASE("Special SAX Parsing Options")
     }
 }
 
+TEST_CASE("SAX Deserialization of Binary Formats")
+{
+    using bytes = std::vector<std::uint8_t>;
+
+    SECTION("MessagePack Round-trip")
+    {
+        using container_type = std::map<std::string, std::vector<std::int64_t>>;
+
+        const container_type source_container = {
+            { "small", { 0, 1, -1, 127, -32 } },
+            { "large", { 70'000, -70'000, std::numeric_limits<std::int64_t>::min(),
+                         std::numeric_limits<std::int64_t>::max() } }
+        };
+
+        const auto msgpack = json_utils::serialize_to_msgpack(source_container);
+        const auto resultant_container = json_utils::deserialize_msgpack<container_type>(msgpack);
+
+        REQUIRE(source_container == resultant_container);
+    }
+
+    SECTION("MessagePack Round-trip of Nested Containers")
+    {
+        using container_type = std::map<std::string, std::map<std::string, std::string>>;
+
+        const container_type source_container = {
+            { "outer", { { "inner", std::string(300, 'x') }, { "empty", "" } } }, { "none", {} }
+        };
+
+        const auto msgpack = json_utils::serialize_to_msgpack(source_container);
+        const auto resultant_container = json_utils::deserialize_msgpack<container_type>(msgpack);
+
+        REQUIRE(source_container == resultant_container);
+    }
+
+    SECTION("MessagePack Round-trip of Floating-Point Numbers")
+    {
+        const std::vector<float> floats = { 1.5f, -0.25f };
+        const std::vector<double> doubles = { 0.1, 1e300 };
+
+        REQUIRE(
+            json_utils::deserialize_msgpack<std::vector<float>>(
+                json_utils::serialize_to_msgpack(floats)) == floats);
+        REQUIRE(
+            json_utils::deserialize_msgpack<std::vector<double>>(
+                json_utils::serialize_to_msgpack(doubles)) == doubles);
+    }
+
+    SECTION("MessagePack Transcoded to JSON")
+    {
+        const std::map<std::string, std::vector<std::shared_ptr<int>>> container = {
+            { "Key One", { std::make_shared<int>(1), nullptr } }, { "Key Two", {} }
+        };
+
+        const auto msgpack = json_utils::serialize_to_msgpack(container);
+
+        json_utils::string_output_stream<> stream;
+        json_utils::writer<decltype(stream)> writer{ stream };
+        json_utils::msgpack_reader{}.parse(msgpack.data(), msgpack.size(), writer);
+
+        REQUIRE(stream.str() == json_utils::serialize_to_json(container));
+    }
+
+    SECTION("Malformed MessagePack")
+    {
+        using container_type = std::vector<int>;
+
+        const bytes truncated = { 0x93, 0x01, 0x02 };
+        const bytes trailing = { 0x91, 0x01, 0x01 };
+        const bytes binary = { 0x91, 0xC4, 0x01, 0x00 };
+        const bytes numeric_key = { 0x81, 0x01, 0x91, 0x01 };
+
+        REQUIRE_THROWS_AS(
+            json_utils::deserialize_msgpack<container_type>(truncated), std::runtime_error);
+        REQUIRE_THROWS_AS(
+            json_utils::deserialize_msgpack<container_type>(trailing), std::runtime_error);
+        REQUIRE_THROWS_AS(
+            json_utils::deserialize_msgpack<container_type>(binary), std::runtime_error);
+
+        using object_type = std::map<std::string, container_type>;
+        REQUIRE_THROWS_AS(
+            json_utils::deserialize_msgpack<object_type>(numeric_key), std::runtime_error);
+    }
+
+    SECTION("CBOR with Definite Lengths")
+    {
+        using container_type = std::map<std::string, std::vector<double>>;
+
+        // {"a": [1, -2, 1.5], "b": []}, where 1.5 is a half-precision float.
+        const bytes cbor = { 0xA2, 0x61, 'a', 0x83, 0x01, 0x21, 0xF9, 0x3E, 0x00, 0x61, 'b', 0x80 };
+
+        const auto resultant_container = json_utils::deserialize_cbor<container_type>(cbor);
+
+        REQUIRE(resultant_container == container_type{ { "a", { 1, -2, 1.5 } }, { "b", {} } });
+    }
+
+    SECTION("CBOR with Indefinite Lengths and Tags")
+    {
+        using container_type = std::map<std::string, std::vector<std::string>>;
+
+        // {_ (_ "ke", "y"): 1([_ "value"])}
+        const bytes cbor = { 0xBF, 0x7F, 0x62, 'k',  'e', 0x61, 'y', 0xFF, 0xC1, 0x9F,
+                             0x65, 'v',  'a',  'l',  'u', 'e',  0xFF, 0xFF };
+
+        const auto resultant_container = json_utils::deserialize_cbor<container_type>(cbor);
+
+        REQUIRE(resultant_container == container_type{ { "key", { "value" } } });
+    }
+
+    SECTION("CBOR Integers Beyond 32 Bits")
+    {
+        using container_type = std::vector<std::int64_t>;
+
+        // [4294967296, -4294967297]
+        const bytes cbor = { 0x82, 0x1B, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00,
+                             0x3B, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00 };
+
+        const auto resultant_container = json_utils::deserialize_cbor<container_type>(cbor);
+
+        REQUIRE(resultant_container == container_type{ 4'294'967'296, -4'294'967'297 });
+    }
+
+    SECTION("Malformed CBOR")
+    {
+        using container_type = std::map<std::string, std::vector<int>>;
+
+        const bytes numeric_key = { 0xA1, 0x01, 0x80 };
+        const bytes byte_string = { 0xA1, 0x61, 'a', 0x81, 0x41, 0x00 };
+        const bytes misplaced_break = { 0xBF, 0x61, 'a', 0xFF };
+
+        REQUIRE_THROWS_AS(
+            json_utils::deserialize_cbor<container_type>(numeric_key), std::runtime_error);
+        REQUIRE_THROWS_AS(
+            json_utils::deserialize_cbor<container_type>(byte_string), std::runtime_error);
+        REQUIRE_THROWS_AS(
+            json_utils::deserialize_cbor<container_type>(misplaced_break), std::runtime_error);
+    }
+}
+
 TEST_CASE("SAX Error Handling")
 {
     SECTION("Invalid JSON Detected Within Custom Handler")